@@ -7,7 +7,10 @@
  * - Simulating delivery routes using BFS
  * 
  * Key Data Structures:
- * - Graph represented using adjacency lists
+ * - Graph represented using adjacency lists (editable form)
+ * - Compressed sparse row (CSR) snapshot of the graph (query form)
+ * - Arena-backed name pool with an open-addressing hash index
+ * - Interned piecewise-linear travel-time profiles for rush-hour ETAs
  * - Priority queue for Dijkstra's algorithm
  * - Queue for BFS simulation
  */
@@ -16,257 +19,5842 @@
 #include <iostream>       // For input/output operations
 #include <vector>         // Dynamic array implementation
 #include <queue>          // For priority_queue and queue
+#include <list>           // For the result cache's recency order
 #include <unordered_map>  // Hash table implementation for fast lookups
+#include <mutex>          // For the result cache shared by query threads
+#include <string_view>    // For allocation-free name lookups
 #include <limits>         // For numeric_limits (infinity representation)
 #include <algorithm>      // For remove_if algorithm
+#include <memory>         // For shared_ptr (published graph snapshots)
+#include <functional>     // For function (pluggable A* heuristics)
+#include <cmath>          // For trigonometry in great-circle distances
+#include <cstdio>         // For sscanf when parsing coordinates
+#include <cstdint>        // For fixed-width integers in binary files
+#include <fstream>        // For landmark table files
+#include <thread>         // For worker threads in batch queries
+#include <atomic>         // For the shared work counter of worker threads
+#include <chrono>         // For load throughput timing
+#include <charconv>       // For from_chars when bulk-parsing numbers
+#include <cstring>        // For memchr when splitting mapped text
+#include <fcntl.h>        // For open (memory-mapped files)
+#include <sys/mman.h>     // For mmap/munmap
+#include <sys/stat.h>     // For fstat (mapped file size)
+#include <unistd.h>       // For close
+#include <type_traits>    // For checking the configured edge storage types
+#include <condition_variable> // For the server mode's worker pool
+#include <deque>          // For the worker pool's task queue
+#include <csignal>        // For ignoring SIGPIPE from closed connections
+#include <cerrno>         // For retrying interrupted reads and writes
+#include <sys/socket.h>   // For the server mode's TCP listener
+#include <netinet/in.h>   // For sockaddr_in
+#include <netinet/tcp.h>  // For TCP_NODELAY
 
 using namespace std; // Standard namespace to avoid std:: prefixes
 
+class MappedFile;
+
 /*
- * DeliveryPathOptimizer class
- * Manages locations, routes, and path optimization algorithms
+ * ArrayView struct
+ * Read-only view of a contiguous array owned elsewhere (a vector or a
+ * memory-mapped file)
  */
-class DeliveryPathOptimizer {
+template<class T>
+struct ArrayView {
+    const T* ptr = nullptr; // First element
+    size_t count = 0;       // Number of elements
+
+    ArrayView() {}
+    ArrayView(const T* p, size_t n) : ptr(p), count(n) {}
+    ArrayView(const vector<T>& v) : ptr(v.data()), count(v.size()) {}
+
+    const T& operator[](size_t i) const { return ptr[i]; }
+    const T* data() const { return ptr; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+};
+
+/*
+ * BasicCSRGraph struct
+ * Immutable compressed sparse row snapshot of the adjacency list.
+ * The neighbors of vertex u occupy the range [offsets[u], offsets[u + 1])
+ * of the packed targets/costs arrays, so a relaxation loop walks
+ * contiguous memory instead of chasing one heap block per location.
+ * The arrays either live in the snapshot itself or point straight into a
+ * memory-mapped graph snapshot file.
+ * IndexT and WeightT set the bytes stored per edge (see CSRGraph).
+ */
+template <class IndexT, class WeightT>
+struct BasicCSRGraph {
+    static_assert(is_integral<IndexT>::value && sizeof(IndexT) == 4,
+                  "vertex indices must be 32-bit integers");
+    static_assert(is_integral<WeightT>::value && sizeof(WeightT) <= 4,
+                  "edge costs must be integers of at most 32 bits");
+    typedef IndexT Index;
+    typedef WeightT Weight;
+
+    ArrayView<int> offsets;      // Size n + 1, start of each vertex's edge range
+    ArrayView<IndexT> targets;   // Neighbor index for every edge
+    ArrayView<WeightT> costs;    // Edge cost for every edge (parallel to targets)
+    int minCost = 0;             // Smallest edge cost (0 if there are no edges)
+    int maxCost = 0;             // Largest edge cost (0 if there are no edges)
+
+    // Whether a route cost can be stored in this layout
+    static bool fitsCost(int cost) {
+        return (long long)cost >= (long long)numeric_limits<WeightT>::min() &&
+               (long long)cost <= (long long)numeric_limits<WeightT>::max();
+    }
+
+    // Tag written into snapshot files: index bytes, cost bytes, cost signedness
+    static uint32_t layoutTag() {
+        return sizeof(IndexT) | (sizeof(WeightT) << 8) | (is_signed<WeightT>::value ? 1u << 16 : 0u);
+    }
+
+    /*
+     * Compiles an adjacency list into CSR form
+     * @param adjList: Editable adjacency list to freeze
+     */
+    explicit BasicCSRGraph(const vector<vector<pair<int, int>>>& adjList)
+        : BasicCSRGraph(adjList, vector<int>()) {}
+
+    /*
+     * Compiles an adjacency list into CSR form with the vertices renumbered,
+     * so that locations visited together also sit together in memory
+     * @param adjList: Editable adjacency list to freeze
+     * @param vertexOrder: Location stored at each vertex (empty keeps identity)
+     */
+    BasicCSRGraph(const vector<vector<pair<int, int>>>& adjList, vector<int> vertexOrder) {
+        int n = adjList.size();
+        locationAt = move(vertexOrder);
+        if (!locationAt.empty()) {
+            vertexAt.resize(n);
+            for (int v = 0; v < n; ++v) vertexAt[locationAt[v]] = v;
+        }
+
+        offsetStore.resize(n + 1);
+        offsetStore[0] = 0;
+        for (int u = 0; u < n; ++u) {
+            offsetStore[u + 1] = offsetStore[u] + adjList[locationOf(u)].size();
+        }
+
+        // Pack all edges back to back in vertex order
+        targetStore.resize(offsetStore[n]);
+        costStore.resize(offsetStore[n]);
+        for (int u = 0; u < n; ++u) {
+            int e = offsetStore[u];
+            for (const auto& p : adjList[locationOf(u)]) {
+                targetStore[e] = (IndexT)vertexOf(p.first);
+                costStore[e] = (WeightT)p.second;
+                ++e;
+            }
+        }
+        offsets = offsetStore;
+        targets = targetStore;
+        costs = costStore;
+
+        // Cost range drives the automatic priority queue choice
+        if (!costs.empty()) {
+            minCost = *min_element(costs.begin(), costs.end());
+            maxCost = *max_element(costs.begin(), costs.end());
+        }
+    }
+
+    /*
+     * Wraps CSR arrays that live inside a memory-mapped file, without copying
+     * @param file: Mapping that holds the arrays (kept alive by the graph)
+     * @param offsetData: n + 1 edge range starts
+     * @param targetData: m neighbor indices
+     * @param costData: m edge costs
+     * @param n: Vertex count
+     * @param m: Directed edge count
+     * @param lo: Smallest edge cost
+     * @param hi: Largest edge cost
+     */
+    BasicCSRGraph(shared_ptr<const MappedFile> file, const int* offsetData, const IndexT* targetData,
+                  const WeightT* costData, int n, int m, int lo, int hi)
+        : offsets(offsetData, n + 1), targets(targetData, m), costs(costData, m),
+          minCost(lo), maxCost(hi), mapping(move(file)) {}
+
+    // Views may point into this object, so it is never copied
+    BasicCSRGraph(const BasicCSRGraph&) = delete;
+    BasicCSRGraph& operator=(const BasicCSRGraph&) = delete;
+
+    // Number of vertices in the snapshot
+    int vertexCount() const { return offsets.size() - 1; }
+
+    // Number of directed edges in the snapshot
+    int edgeCount() const { return targets.size(); }
+
+    // Vertex that stores a location
+    int vertexOf(int location) const { return vertexAt.empty() ? location : vertexAt[location]; }
+
+    // Location stored at a vertex
+    int locationOf(int vertex) const { return locationAt.empty() ? vertex : locationAt[vertex]; }
+
+    // Whether vertex numbers differ from location indices
+    bool reordered() const { return !locationAt.empty(); }
+
 private:
-    // Maps location names to their indices for quick lookup
-    unordered_map<string, int> locationToIndex;
-    
-    // Maps indices back to location names for display
-    vector<string> indexToLocation;
-    
-    // Adjacency list representation of the graph
-    // Each entry is a vector of pairs: (neighbor_index, cost)
-    vector<vector<pair<int, int>>> adjList;
-    
-    // Total number of locations in the system
-    int locationCount;
+    vector<int> offsetStore;               // Owned arrays (empty when mapped)
+    vector<IndexT> targetStore;
+    vector<WeightT> costStore;
+    vector<int> locationAt;                // Location of each vertex (empty for identity)
+    vector<int> vertexAt;                  // Vertex of each location (empty for identity)
+    shared_ptr<const MappedFile> mapping;  // Owner of mapped arrays (null when owned)
+};
+
+// Edge storage of the query snapshot. A target plus a cost takes 8 bytes by
+// default; build with -DDELPATHOPT_COST_TYPE=uint16_t (route costs 0..65535)
+// to store 6 bytes per edge. Routes whose cost does not fit are rejected.
+#ifndef DELPATHOPT_INDEX_TYPE
+#define DELPATHOPT_INDEX_TYPE int32_t
+#endif
+#ifndef DELPATHOPT_COST_TYPE
+#define DELPATHOPT_COST_TYPE int32_t
+#endif
+typedef BasicCSRGraph<DELPATHOPT_INDEX_TYPE, DELPATHOPT_COST_TYPE> CSRGraph;
+
+/*
+ * MappedFile class
+ * Read-only memory mapping of a whole file. The contents are paged in by
+ * the kernel on first touch, so parsers can scan them in place without
+ * copying them through stream buffers.
+ */
+class MappedFile {
+    const char* bytes = nullptr; // Start of the mapping (null if unmapped or empty)
+    size_t length = 0;           // Mapped size in bytes
+
+public:
+    MappedFile() {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    /*
+     * Maps a file, replacing any previous mapping
+     * @param path: File to map
+     * @param sequential: Hint that the file is read front to back once
+     * @return: False if the file could not be opened or mapped
+     */
+    bool open(const string& path, bool sequential = false) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        bool ok = fstat(fd, &info) == 0;
+        if (ok && info.st_size > 0) {
+            void* addr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                ok = false;
+            } else {
+                bytes = static_cast<const char*>(addr);
+                length = info.st_size;
+                if (sequential) madvise(addr, length, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd); // The mapping stays valid after the descriptor is closed
+        return ok;
+    }
+
+    // Unmaps the file (no-op if nothing is mapped)
+    void close() {
+        if (bytes) munmap(const_cast<char*>(bytes), length);
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+/*
+ * Calls fn(begin, end) for each line of a text buffer, without the line
+ * terminator ("\n" or "\r\n")
+ * @param text: Buffer start
+ * @param size: Buffer length in bytes
+ * @param fn: Line callback
+ */
+template<class LineFn>
+void forEachLine(const char* text, size_t size, LineFn fn) {
+    const char* end = text + size;
+    while (text < end) {
+        const char* eol = static_cast<const char*>(memchr(text, '\n', end - text));
+        if (!eol) eol = end;
+        const char* last = eol;
+        if (last > text && last[-1] == '\r') --last;
+        fn(text, last);
+        text = eol + 1;
+    }
+}
+
+/*
+ * Counts the lines of a text buffer (an upper bound on its records)
+ * @param text: Buffer start
+ * @param size: Buffer length in bytes
+ */
+inline size_t countLines(const char* text, size_t size) {
+    size_t lines = 0;
+    const char* end = text + size;
+    while (text < end) {
+        const char* eol = static_cast<const char*>(memchr(text, '\n', end - text));
+        lines++;
+        if (!eol) break;
+        text = eol + 1;
+    }
+    return lines;
+}
+
+/*
+ * Parses an entire field as a number (no leading or trailing junk)
+ * @param begin: Field start
+ * @param end: Field end
+ * @param value: Parsed value (unchanged on failure)
+ * @return: False if the field is not exactly one number
+ */
+template<class T>
+bool parseField(const char* begin, const char* end, T& value) {
+    T parsed;
+    auto res = from_chars(begin, end, parsed);
+    if (res.ec != errc() || res.ptr != end) return false;
+    value = parsed;
+    return true;
+}
+
+/*
+ * Priority queue backends available to Dijkstra
+ */
+enum class HeapKind {
+    Auto,              // Choose from the graph's edge cost range
+    Binary,            // Lazy-deletion binary heap (std::priority_queue)
+    QuaternaryIndexed, // Indexed 4-ary heap with decrease-key
+    Radix,             // Monotone radix heap for non-negative integer keys
+    Dial               // Circular bucket queue for small integer costs
+};
+
+// Largest edge cost for which HeapKind::Auto picks the Dial bucket queue
+const int DIAL_MAX_COST = 1024;
+
+/*
+ * All queue backends share one interface:
+ *   reset(n, maxCost)  prepare for a search over n vertices
+ *   push(key, v)       insert v (lazy queues) or insert/decrease-key (indexed)
+ *   pop()              remove and return the minimum (key, vertex)
+ *   empty()            true if nothing is left
+ * Lazy queues may return stale entries; Dijkstra skips them as before.
+ */
+
+/*
+ * BinaryHeapQueue class
+ * The original std::priority_queue min-heap with lazy deletion
+ */
+class BinaryHeapQueue {
+private:
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+
+public:
+    void reset(int, int) {
+        while (!pq.empty()) pq.pop();
+    }
+    bool empty() const { return pq.empty(); }
+    int peekKey() const { return pq.top().first; }
+    void push(int key, int v) { pq.push(make_pair(key, v)); }
+    pair<int, int> pop() {
+        pair<int, int> top = pq.top(); pq.pop();
+        return top;
+    }
+};
+
+/*
+ * DialQueue class
+ * Dial's bucket queue. While Dijkstra pops key d, every queued key lies in
+ * [d, d + maxCost], so maxCost + 1 circular buckets give O(1) push/pop.
+ */
+class DialQueue {
+private:
+    vector<vector<int>> buckets; // Vertices by key modulo bucket count
+    int current;                 // Key of the bucket being drained
+    int count;                   // Entries queued (including stale ones)
+
+public:
+    DialQueue() : current(0), count(0) {}
+
+    void reset(int, int maxCost) {
+        size_t size = (size_t)max(maxCost, 0) + 1;
+        if (buckets.size() != size) buckets.assign(size, vector<int>());
+        for (auto& b : buckets) b.clear();
+        current = 0;
+        count = 0;
+    }
+    bool empty() const { return count == 0; }
+    void push(int key, int v) {
+        buckets[key % buckets.size()].push_back(v);
+        count++;
+    }
+    pair<int, int> pop() {
+        // Advance to the next non-empty bucket
+        while (buckets[current % buckets.size()].empty()) current++;
+        vector<int>& b = buckets[current % buckets.size()];
+        int v = b.back(); b.pop_back();
+        count--;
+        return make_pair(current, v);
+    }
+};
+
+/*
+ * RadixHeapQueue class
+ * Monotone radix heap: an entry lives in the bucket given by the highest bit
+ * where its key differs from the last popped key, so every entry moves
+ * to a lower bucket at most 32 times in total.
+ */
+class RadixHeapQueue {
+private:
+    vector<pair<int, int>> buckets[33]; // (key, vertex) per bit bucket
+    unsigned last;                      // Last popped key
+    int count;                          // Entries queued
+
+    int bucketOf(unsigned key) const {
+        return key == last ? 0 : 32 - __builtin_clz(key ^ last);
+    }
+
+public:
+    RadixHeapQueue() : last(0), count(0) {}
+
+    void reset(int, int) {
+        for (auto& b : buckets) b.clear();
+        last = 0;
+        count = 0;
+    }
+    bool empty() const { return count == 0; }
+    void push(int key, int v) {
+        buckets[bucketOf(key)].push_back(make_pair(key, v));
+        count++;
+    }
+    pair<int, int> pop() {
+        if (buckets[0].empty()) {
+            // Find the first non-empty bucket and redistribute around its minimum
+            int i = 1;
+            while (buckets[i].empty()) i++;
+            unsigned smallest = numeric_limits<unsigned>::max();
+            for (const auto& entry : buckets[i]) smallest = min(smallest, (unsigned)entry.first);
+            last = smallest;
+            for (const auto& entry : buckets[i]) buckets[bucketOf(entry.first)].push_back(entry);
+            buckets[i].clear();
+        }
+        pair<int, int> top = buckets[0].back(); buckets[0].pop_back();
+        count--;
+        return top;
+    }
+};
+
+/*
+ * IndexedQuaternaryHeap class
+ * 4-ary min-heap over vertices with a position index, so push() on a
+ * queued vertex is a decrease-key and the heap never holds stale entries
+ */
+class IndexedQuaternaryHeap {
+private:
+    vector<int> heap;     // Vertices in heap order
+    vector<int> keyOf;    // Current key per vertex
+    vector<int> position; // Heap slot per vertex, -1 if not queued
+
+    void place(int slot, int v) {
+        heap[slot] = v;
+        position[v] = slot;
+    }
+
+    void siftUp(int slot) {
+        int v = heap[slot];
+        while (slot > 0) {
+            int parent = (slot - 1) / 4;
+            if (keyOf[heap[parent]] <= keyOf[v]) break;
+            place(slot, heap[parent]);
+            slot = parent;
+        }
+        place(slot, v);
+    }
+
+    void siftDown(int slot) {
+        int v = heap[slot];
+        int size = heap.size();
+        while (true) {
+            int first = slot * 4 + 1;
+            if (first >= size) break;
+
+            // Smallest of up to four children
+            int best = first;
+            int last = min(first + 4, size);
+            for (int c = first + 1; c < last; ++c) {
+                if (keyOf[heap[c]] < keyOf[heap[best]]) best = c;
+            }
+            if (keyOf[heap[best]] >= keyOf[v]) break;
+            place(slot, heap[best]);
+            slot = best;
+        }
+        place(slot, v);
+    }
+
+public:
+    void reset(int n, int) {
+        // Only vertices left over from an early-terminated search need clearing
+        for (int v : heap) position[v] = -1;
+        heap.clear();
+        if ((int)position.size() != n) {
+            position.assign(n, -1);
+            keyOf.assign(n, 0);
+        }
+    }
+    bool empty() const { return heap.empty(); }
+    void push(int key, int v) {
+        if (position[v] < 0) {
+            keyOf[v] = key;
+            heap.push_back(v);
+            position[v] = heap.size() - 1;
+            siftUp(heap.size() - 1);
+        } else if (key < keyOf[v]) {
+            keyOf[v] = key;
+            siftUp(position[v]);
+        }
+    }
+    pair<int, int> pop() {
+        int top = heap[0];
+        int last = heap.back(); heap.pop_back();
+        position[top] = -1;
+        if (!heap.empty()) {
+            place(0, last);
+            siftDown(0);
+        }
+        return make_pair(keyOf[top], top);
+    }
+};
+
+/*
+ * SearchSpace class
+ * Distance and predecessor labels for one search direction. Every slot is
+ * stamped with the generation that wrote it, so reset() is O(1): labels
+ * from older generations read as "unreached" without clearing the arrays.
+ */
+class SearchSpace {
+private:
+    vector<int> dist;       // Distance label per vertex (valid if stamped)
+    vector<int> pred;       // Predecessor per vertex (valid if stamped)
+    vector<uint32_t> stamp; // Generation that last wrote each slot
+    uint32_t generation;    // Current generation
+    vector<int> touched;    // Vertices reached in the current generation
+
+public:
+    SearchSpace() : generation(0) {}
+
+    /*
+     * Starts a new search over n vertices in O(touched) time
+     * (O(n) only when the vertex count changes or the stamp wraps)
+     */
+    void reset(int n) {
+        touched.clear();
+        if ((int)stamp.size() != n) {
+            dist.resize(n);
+            pred.resize(n);
+            stamp.assign(n, 0);
+            generation = 0;
+        }
+        if (++generation == 0) {
+            // Stamp counter wrapped: old stamps could alias the new generation
+            fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+    }
+
+    // Whether v has a label in the current search
+    bool reached(int v) const { return stamp[v] == generation; }
+
+    // Distance label of v ("infinity" if unreached)
+    int distance(int v) const { return reached(v) ? dist[v] : numeric_limits<int>::max(); }
+
+    // Predecessor of v (-1 if unreached or the origin)
+    int predecessor(int v) const { return reached(v) ? pred[v] : -1; }
+
+    // Sets the labels of v, recording it as touched on first reach
+    void set(int v, int d, int p) {
+        if (!reached(v)) {
+            stamp[v] = generation;
+            touched.push_back(v);
+        }
+        dist[v] = d;
+        pred[v] = p;
+    }
+
+    // Vertices labelled during the current search, in first-reach order
+    const vector<int>& touchedVertices() const { return touched; }
+
+    // Raw label arrays for the vectorized relaxation kernels: a slot's
+    // distance is valid only where its stamp equals currentGeneration()
+    const int* labels() const { return dist.data(); }
+    const uint32_t* stamps() const { return stamp.data(); }
+    uint32_t currentGeneration() const { return generation; }
+};
+
+/*
+ * QueryWorkspace class
+ * Reusable buffers for one query at a time: search labels and every queue
+ * backend. Reusing one workspace per worker thread removes the per-query
+ * allocation and O(n) initialisation; it must not be shared by concurrent
+ * queries.
+ */
+class QueryWorkspace {
+public:
+    SearchSpace forward;      // Labels of (forward) searches and BFS
+    SearchSpace backward;     // Labels of the backward side of bidirectional searches
+    SearchSpace estimates;    // Cached A* estimates (stored as distance labels)
+
+    BinaryHeapQueue binary;   // Queue backends, kept warm between queries
+    DialQueue dial;
+    RadixHeapQueue radix;
+    IndexedQuaternaryHeap quaternary;
+    BinaryHeapQueue sides[2]; // Per-direction queues for bidirectional searches
+
+    vector<pair<long long, int>> goalHeap; // Heap storage for A* (wide keys)
+};
+
+/*
+ * Resolves HeapKind::Auto (and unsafe requests) to a concrete backend.
+ * Bucket and radix queues need non-negative costs; Dial also needs a small
+ * cost range. The binary heap stays as the fallback for anything else.
+ * @param kind: Requested backend
+ * @param g: Graph the search will run on
+ */
+inline HeapKind resolveHeapKind(HeapKind kind, const CSRGraph& g) {
+    bool nonNegative = g.minCost >= 0;
+    if (kind == HeapKind::Auto) {
+        if (!nonNegative) return HeapKind::Binary;
+        return (g.maxCost <= DIAL_MAX_COST) ? HeapKind::Dial : HeapKind::QuaternaryIndexed;
+    }
+    if ((kind == HeapKind::Dial || kind == HeapKind::Radix) && !nonNegative) return HeapKind::Binary;
+    if (kind == HeapKind::Dial && g.maxCost > DIAL_MAX_COST) return HeapKind::QuaternaryIndexed;
+    return kind;
+}
+
+// Vectorized relaxation. Searches spend most of their time at hubs scanning
+// long edge lists, so the AVX2 and AVX-512 kernels below test 8 or 16
+// edges at a time with gathers. The instruction set is picked at run time.
+// Other targets, and builds with -DDELPATHOPT_SIMD=0, keep the scalar loop.
+#ifndef DELPATHOPT_SIMD
+#define DELPATHOPT_SIMD 1
+#endif
+#if DELPATHOPT_SIMD && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DELPATHOPT_SIMD_X86 1
+#include <immintrin.h>    // For AVX2/AVX-512 intrinsics
+#else
+#define DELPATHOPT_SIMD_X86 0
+#endif
+
+/*
+ * Instruction sets of the relaxation kernels
+ */
+enum class SimdLevel {
+    Scalar,  // Plain loop
+    AVX2,    // 8 edges per step
+    AVX512   // 16 edges per step
+};
+
+const int SIMD_MIN_DEGREE = 32; // Shorter edge lists stay on the scalar loop
+const int SIMD_CHUNK = 256;     // Edges tested per kernel call
+
+// Best level this CPU supports
+inline SimdLevel detectedSimdLevel() {
+#if DELPATHOPT_SIMD_X86
+    static const SimdLevel level = __builtin_cpu_supports("avx512f") ? SimdLevel::AVX512
+                                 : __builtin_cpu_supports("avx2")    ? SimdLevel::AVX2
+                                                                     : SimdLevel::Scalar;
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+// Process-wide kernel choice, starting at the detected level
+inline atomic<int>& simdLevelSetting() {
+    static atomic<int> level((int)detectedSimdLevel());
+    return level;
+}
+
+// Level searches currently use
+inline SimdLevel activeSimdLevel() {
+    return (SimdLevel)simdLevelSetting().load(memory_order_relaxed);
+}
+
+/*
+ * Chooses the relaxation kernels for every search in the process, e.g. to
+ * benchmark them against the scalar loop
+ * @param level: Requested level (lowered to what the CPU supports)
+ * @return: Level now in use
+ */
+inline SimdLevel setSimdLevel(SimdLevel level) {
+    if ((int)level > (int)detectedSimdLevel()) level = detectedSimdLevel();
+    simdLevelSetting().store((int)level, memory_order_relaxed);
+    return level;
+}
+
+#if DELPATHOPT_SIMD_X86
+// Loads 8 edge costs widened to 32 bits
+__attribute__((target("avx2"))) inline __m256i loadCosts8(const int32_t* c) { return _mm256_loadu_si256((const __m256i*)c); }
+__attribute__((target("avx2"))) inline __m256i loadCosts8(const uint32_t* c) { return _mm256_loadu_si256((const __m256i*)c); }
+__attribute__((target("avx2"))) inline __m256i loadCosts8(const int16_t* c) { return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)c)); }
+__attribute__((target("avx2"))) inline __m256i loadCosts8(const uint16_t* c) { return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)c)); }
+__attribute__((target("avx2"))) inline __m256i loadCosts8(const int8_t* c) { return _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)c)); }
+__attribute__((target("avx2"))) inline __m256i loadCosts8(const uint8_t* c) { return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)c)); }
+
+// Loads 16 edge costs widened to 32 bits. The widening forms are the
+// zero-masked ones with every lane selected: GCC spells the unmasked
+// intrinsics with an undefined pass-through and warns about it.
+__attribute__((target("avx512f"))) inline __m512i loadCosts16(const int32_t* c) { return _mm512_loadu_si512(c); }
+__attribute__((target("avx512f"))) inline __m512i loadCosts16(const uint32_t* c) { return _mm512_loadu_si512(c); }
+__attribute__((target("avx512f"))) inline __m512i loadCosts16(const int16_t* c) { return _mm512_maskz_cvtepi16_epi32(0xFFFF, _mm256_loadu_si256((const __m256i*)c)); }
+__attribute__((target("avx512f"))) inline __m512i loadCosts16(const uint16_t* c) { return _mm512_maskz_cvtepu16_epi32(0xFFFF, _mm256_loadu_si256((const __m256i*)c)); }
+__attribute__((target("avx512f"))) inline __m512i loadCosts16(const int8_t* c) { return _mm512_maskz_cvtepi8_epi32(0xFFFF, _mm_loadu_si128((const __m128i*)c)); }
+__attribute__((target("avx512f"))) inline __m512i loadCosts16(const uint8_t* c) { return _mm512_maskz_cvtepu8_epi32(0xFFFF, _mm_loadu_si128((const __m128i*)c)); }
+
+/*
+ * AVX2 kernel of improvingEdges(): gathers the stamp and label of 8
+ * targets at once and keeps the edges whose target is unreached or has a
+ * longer label than d + cost
+ */
+template <class WeightT>
+__attribute__((target("avx2")))
+int improvingEdgesAvx2(const int32_t* targets, const WeightT* costs, int count, const int* dist,
+                       const uint32_t* stamp, uint32_t generation, int d, int* out) {
+    const __m256i gen = _mm256_set1_epi32((int)generation);
+    const __m256i base = _mm256_set1_epi32(d);
+    int found = 0, e = 0;
+    for (; e + 8 <= count; e += 8) {
+        __m256i t = _mm256_loadu_si256((const __m256i*)(targets + e));
+        __m256i candidate = _mm256_add_epi32(base, loadCosts8(costs + e));
+        __m256i stamps = _mm256_i32gather_epi32((const int*)stamp, t, 4);
+        __m256i fresh = _mm256_cmpeq_epi32(stamps, gen);
+        __m256i labels = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), dist, t, fresh, 4); // Reached lanes only
+        __m256i longer = _mm256_and_si256(fresh, _mm256_cmpgt_epi32(labels, candidate));
+        unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(
+            _mm256_xor_si256(fresh, _mm256_set1_epi32(-1)), longer)));
+        for (; mask; mask &= mask - 1) out[found++] = e + __builtin_ctz(mask);
+    }
+    for (; e < count; ++e) {
+        int v = targets[e];
+        if (stamp[v] != generation || dist[v] > d + (int)costs[e]) out[found++] = e;
+    }
+    return found;
+}
+
+/*
+ * AVX-512 kernel of improvingEdges(), 16 edges per step
+ */
+template <class WeightT>
+__attribute__((target("avx512f")))
+int improvingEdgesAvx512(const int32_t* targets, const WeightT* costs, int count, const int* dist,
+                         const uint32_t* stamp, uint32_t generation, int d, int* out) {
+    const __m512i gen = _mm512_set1_epi32((int)generation);
+    const __m512i base = _mm512_set1_epi32(d);
+    int found = 0, e = 0;
+    for (; e + 16 <= count; e += 16) {
+        __m512i t = _mm512_loadu_si512(targets + e);
+        __m512i candidate = _mm512_add_epi32(base, loadCosts16(costs + e));
+        __m512i stamps = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, t, (const int*)stamp, 4);
+        __mmask16 reached = _mm512_cmpeq_epi32_mask(stamps, gen);
+        __m512i labels = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), reached, t, dist, 4); // Reached lanes only
+        unsigned mask = (unsigned)(~reached & 0xFFFF) | _mm512_mask_cmpgt_epi32_mask(reached, labels, candidate);
+        for (; mask; mask &= mask - 1) out[found++] = e + __builtin_ctz(mask);
+    }
+    for (; e < count; ++e) {
+        int v = targets[e];
+        if (stamp[v] != generation || dist[v] > d + (int)costs[e]) out[found++] = e;
+    }
+    return found;
+}
+#endif
+
+/*
+ * Picks the edges of a range that may improve their target's label, as
+ * edge indices in order. The result can include edges a relaxation made
+ * earlier in the same range has since made useless, so callers re-test
+ * each one; an edge left out can never improve.
+ * @param level: Kernel to use (not Scalar)
+ * @param g: Graph snapshot being searched
+ * @param begin: First edge of the range
+ * @param end: One past the last edge (at most SIMD_CHUNK edges)
+ * @param space: Labels of the search
+ * @param d: Distance of the vertex being scanned
+ * @param out: Receives the picked edge indices
+ * @return: Number of edges picked
+ */
+inline int improvingEdges(SimdLevel level, const CSRGraph& g, int begin, int end, const SearchSpace& space,
+                          int d, int* out) {
+    int found = 0;
+#if DELPATHOPT_SIMD_X86
+    const int32_t* targets = (const int32_t*)g.targets.data() + begin;
+    const CSRGraph::Weight* costs = g.costs.data() + begin;
+    if (level == SimdLevel::AVX512) {
+        found = improvingEdgesAvx512(targets, costs, end - begin, space.labels(), space.stamps(), space.currentGeneration(), d, out);
+    } else {
+        found = improvingEdgesAvx2(targets, costs, end - begin, space.labels(), space.stamps(), space.currentGeneration(), d, out);
+    }
+#else
+    (void)level;
+    for (int e = 0; e < end - begin; ++e) {
+        if (space.distance(g.targets[begin + e]) > d + (int)g.costs[begin + e]) out[found++] = e;
+    }
+#endif
+    for (int k = 0; k < found; ++k) out[k] += begin;
+    return found;
+}
+
+#if DELPATHOPT_SIMD_X86
+/*
+ * AVX2 kernel of lowerRowEntries(): min of 8 gathered entries at a time,
+ * stored back lane by lane (AVX2 has no scatter)
+ */
+__attribute__((target("avx2")))
+inline void lowerRowEntriesAvx2(int* row, const int* cols, const int* dists, int count, int base) {
+    const __m256i offset = _mm256_set1_epi32(base);
+    int k = 0;
+    for (; k + 8 <= count; k += 8) {
+        __m256i c = _mm256_loadu_si256((const __m256i*)(cols + k));
+        __m256i candidate = _mm256_add_epi32(offset, _mm256_loadu_si256((const __m256i*)(dists + k)));
+        __m256i current = _mm256_i32gather_epi32(row, c, 4);
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(current, candidate)));
+        for (; mask; mask &= mask - 1) {
+            int lane = __builtin_ctz(mask);
+            row[cols[k + lane]] = base + dists[k + lane];
+        }
+    }
+    for (; k < count; ++k) row[cols[k]] = min(row[cols[k]], base + dists[k]);
+}
+
+/*
+ * AVX-512 kernel of lowerRowEntries(): gather, min and masked scatter of
+ * 16 entries at a time
+ */
+__attribute__((target("avx512f")))
+inline void lowerRowEntriesAvx512(int* row, const int* cols, const int* dists, int count, int base) {
+    const __m512i offset = _mm512_set1_epi32(base);
+    int k = 0;
+    for (; k + 16 <= count; k += 16) {
+        __m512i c = _mm512_loadu_si512(cols + k);
+        __m512i candidate = _mm512_add_epi32(offset, _mm512_loadu_si512(dists + k));
+        __m512i current = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF, c, row, 4);
+        __mmask16 lower = _mm512_cmpgt_epi32_mask(current, candidate);
+        _mm512_mask_i32scatter_epi32(row, lower, c, candidate, 4);
+    }
+    for (; k < count; ++k) row[cols[k]] = min(row[cols[k]], base + dists[k]);
+}
+#endif
+
+/*
+ * Lowers row[cols[k]] to base + dists[k] where that is smaller, for the
+ * bucket scans of the many-to-many matrix. The columns of one call must be
+ * distinct, as they are within one vertex's bucket.
+ * @param level: Kernel to use
+ * @param row: Matrix row being filled
+ * @param cols: Column of each entry
+ * @param dists: Distance of each entry from its column's target
+ * @param count: Number of entries
+ * @param base: Distance from the row's source to the bucket's vertex
+ */
+inline void lowerRowEntries(SimdLevel level, int* row, const int* cols, const int* dists, int count, int base) {
+#if DELPATHOPT_SIMD_X86
+    if (level == SimdLevel::AVX512 && count >= 16) {
+        lowerRowEntriesAvx512(row, cols, dists, count, base);
+        return;
+    }
+    if (level == SimdLevel::AVX2 && count >= 8) {
+        lowerRowEntriesAvx2(row, cols, dists, count, base);
+        return;
+    }
+#else
+    (void)level;
+#endif
+    for (int k = 0; k < count; ++k) row[cols[k]] = min(row[cols[k]], base + dists[k]);
+}
+
+// Hot-path instrumentation: search counters and per-query latency
+// histograms, exported in Prometheus text format by
+// DeliveryPathOptimizer::metricsText(). Every thread records into its own
+// slot, so the hot path never writes a shared cache line. Build with
+// -DDELPATHOPT_METRICS=0 to compile the recording out.
+#ifndef DELPATHOPT_METRICS
+#define DELPATHOPT_METRICS 1
+#endif
+
+/*
+ * Query types with a latency histogram of their own
+ */
+enum class QueryKind {
+    DeliveryPlan,          // optimizeDeliveryPlan
+    DeliveryPlanAt,        // optimizeDeliveryPlanAt
+    ShortestPath,          // shortestPath
+    ServiceArea,           // serviceArea
+    DistanceMatrix,        // distanceMatrix
+    DeliveryTour,          // planDeliveryTour
+    ParallelDeliveryPlan,  // parallelDeliveryPlan (delta-stepping)
+    Simulation,            // simulateDelivery, either BFS mode
+    BatchOptimize,         // batchOptimize, the whole batch
+    Count
+};
+
+/*
+ * LatencyHistogram class
+ * Log-linear latency histogram in the style of HdrHistogram. Each power of
+ * two of nanoseconds is split into 16 equal buckets, so a recorded value is
+ * known to within 1/16 of itself from 1 ns to about 18 minutes in a fixed
+ * 592 buckets. Written by one thread, readable from any.
+ */
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKETS = 16;                     // Buckets per power of two
+    static const int POWERS = 36;                          // Powers of two from 16 ns
+    static const int BUCKETS = SUB_BUCKETS * (POWERS + 1); // Plus one linear range below 16 ns
+    static const uint64_t MAX_NANOS = (uint64_t(1) << 40) - 1;
+
+    // Bucket holding a value
+    static int bucketOf(uint64_t nanos) {
+        if (nanos > MAX_NANOS) nanos = MAX_NANOS;
+        if (nanos < (uint64_t)SUB_BUCKETS) return (int)nanos;
+        int exponent = 63 - __builtin_clzll(nanos); // 4..39
+        int shift = exponent - 4;
+        return SUB_BUCKETS * (shift + 1) + (int)(nanos >> shift) - SUB_BUCKETS;
+    }
+
+    // Smallest value of a bucket
+    static uint64_t lowerBound(int bucket) {
+        if (bucket < SUB_BUCKETS) return (uint64_t)bucket;
+        int shift = bucket / SUB_BUCKETS - 1;
+        return (uint64_t)(bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    }
+
+    // Width of a bucket
+    static uint64_t width(int bucket) {
+        return bucket < SUB_BUCKETS ? 1 : uint64_t(1) << (bucket / SUB_BUCKETS - 1);
+    }
+
+    /*
+     * Records one query (owner thread only)
+     * @param nanos: Latency in nanoseconds
+     * @param origin: Location index the query started from (-1 if none)
+     */
+    void record(uint64_t nanos, int origin) {
+        bump(counts[bucketOf(nanos)], 1);
+        bump(total, 1);
+        bump(sumNanos, nanos);
+        if (nanos > maxNanos.load(memory_order_relaxed)) {
+            maxNanos.store(nanos, memory_order_relaxed);
+            slowestOrigin.store(origin, memory_order_relaxed);
+        }
+    }
+
+    // Adds one of the single-writer counters without a locked instruction
+    static void bump(atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(memory_order_relaxed) + amount, memory_order_relaxed);
+    }
+
+    atomic<uint64_t> counts[BUCKETS] = {};
+    atomic<uint64_t> total{0};          // Queries recorded
+    atomic<uint64_t> sumNanos{0};       // Sum of their latencies
+    atomic<uint64_t> maxNanos{0};       // Slowest latency
+    atomic<int> slowestOrigin{-1};      // Origin of the slowest query
+};
+
+/*
+ * LatencyStats struct
+ * Merged latency histogram of one query type
+ */
+struct LatencyStats {
+    vector<uint64_t> counts = vector<uint64_t>(LatencyHistogram::BUCKETS); // Per bucket
+    uint64_t total = 0;       // Queries recorded
+    uint64_t sumNanos = 0;    // Sum of their latencies
+    uint64_t maxNanos = 0;    // Slowest latency
+    int slowestOrigin = -1;   // Location index of the slowest query's origin
+
+    /*
+     * Latency below which a fraction of the queries fall
+     * @param q: Fraction in [0, 1]
+     * @return: Midpoint of the bucket holding that rank, in nanoseconds
+     */
+    uint64_t percentile(double q) const {
+        if (total == 0) return 0;
+        uint64_t rank = (uint64_t)ceil(q * (double)total);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) {
+            seen += counts[b];
+            if (seen >= rank) {
+                uint64_t mid = LatencyHistogram::lowerBound(b) + LatencyHistogram::width(b) / 2;
+                return min(mid, maxNanos);
+            }
+        }
+        return maxNanos;
+    }
+};
+
+/*
+ * QueryMetrics struct
+ * Process-wide totals of the instrumentation counters
+ */
+struct QueryMetrics {
+    uint64_t heapPushes = 0;        // Priority queue pushes
+    uint64_t stalePops = 0;         // Pops skipped because a shorter label was found later
+    uint64_t edgesRelaxed = 0;      // Edges examined from settled vertices
+    uint64_t verticesSettled = 0;   // Vertices settled
+    LatencyStats latency[(int)QueryKind::Count];
+};
+
+/*
+ * MetricsRegistry class
+ * Owner of the per-thread counter slots. A thread's slot is registered on
+ * its first recording and folded into the retired totals when the thread
+ * exits, so short-lived worker threads are not lost.
+ */
+class MetricsRegistry {
+public:
+    struct ThreadSlot {
+        atomic<uint64_t> heapPushes{0};
+        atomic<uint64_t> stalePops{0};
+        atomic<uint64_t> edgesRelaxed{0};
+        atomic<uint64_t> verticesSettled{0};
+        LatencyHistogram latency[(int)QueryKind::Count];
+    };
+
+    static MetricsRegistry& instance() {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    // Slot of the calling thread
+    static ThreadSlot& local() {
+        static thread_local SlotOwner owner(instance());
+        return *owner.slot;
+    }
+
+    // Totals over live and exited threads
+    QueryMetrics collect() const {
+        lock_guard<mutex> guard(lock);
+        QueryMetrics totals = retired;
+        for (const ThreadSlot* slot : live) accumulate(*slot, totals);
+        return totals;
+    }
+
+private:
+    struct SlotOwner {
+        MetricsRegistry& registry;
+        unique_ptr<ThreadSlot> slot;
+
+        explicit SlotOwner(MetricsRegistry& r) : registry(r), slot(new ThreadSlot()) {
+            lock_guard<mutex> guard(registry.lock);
+            registry.live.push_back(slot.get());
+        }
+        ~SlotOwner() {
+            lock_guard<mutex> guard(registry.lock);
+            accumulate(*slot, registry.retired);
+            registry.live.erase(find(registry.live.begin(), registry.live.end(), slot.get()));
+        }
+    };
+
+    static void accumulate(const ThreadSlot& slot, QueryMetrics& totals) {
+        totals.heapPushes += slot.heapPushes.load(memory_order_relaxed);
+        totals.stalePops += slot.stalePops.load(memory_order_relaxed);
+        totals.edgesRelaxed += slot.edgesRelaxed.load(memory_order_relaxed);
+        totals.verticesSettled += slot.verticesSettled.load(memory_order_relaxed);
+        for (int k = 0; k < (int)QueryKind::Count; ++k) {
+            const LatencyHistogram& h = slot.latency[k];
+            LatencyStats& s = totals.latency[k];
+            for (int b = 0; b < LatencyHistogram::BUCKETS; ++b) s.counts[b] += h.counts[b].load(memory_order_relaxed);
+            s.total += h.total.load(memory_order_relaxed);
+            s.sumNanos += h.sumNanos.load(memory_order_relaxed);
+            uint64_t slowest = h.maxNanos.load(memory_order_relaxed);
+            if (slowest > s.maxNanos) {
+                s.maxNanos = slowest;
+                s.slowestOrigin = h.slowestOrigin.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    mutable mutex lock;
+    vector<ThreadSlot*> live;   // Slots of running threads
+    QueryMetrics retired;       // Totals of exited threads
+};
+
+/*
+ * Adds one search's counters to the calling thread's slot
+ * @param pushes: Queue pushes
+ * @param stale: Outdated queue entries skipped
+ * @param relaxed: Edges examined
+ * @param settled: Vertices settled
+ */
+inline void recordSearch(uint64_t pushes, uint64_t stale, uint64_t relaxed, uint64_t settled) {
+#if DELPATHOPT_METRICS
+    MetricsRegistry::ThreadSlot& slot = MetricsRegistry::local();
+    LatencyHistogram::bump(slot.heapPushes, pushes);
+    LatencyHistogram::bump(slot.stalePops, stale);
+    LatencyHistogram::bump(slot.edgesRelaxed, relaxed);
+    LatencyHistogram::bump(slot.verticesSettled, settled);
+#else
+    (void)pushes; (void)stale; (void)relaxed; (void)settled;
+#endif
+}
+
+/*
+ * QueryTimer class
+ * Records the latency of a query into its type's histogram when it goes
+ * out of scope. Queries made from inside another timed query (the matrix
+ * of a delivery tour, say) are counted only as part of the outer one.
+ */
+class QueryTimer {
+public:
+    QueryTimer(QueryKind kind, int origin) {
+#if DELPATHOPT_METRICS
+        outermost = (depth()++ == 0);
+        if (!outermost) return;
+        this->kind = kind;
+        this->origin = origin;
+        started = chrono::steady_clock::now();
+#else
+        (void)kind; (void)origin;
+#endif
+    }
+
+    ~QueryTimer() {
+#if DELPATHOPT_METRICS
+        depth()--;
+        if (!outermost) return;
+        auto nanos = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - started).count();
+        MetricsRegistry::local().latency[(int)kind].record((uint64_t)nanos, origin);
+#endif
+    }
+
+    QueryTimer(const QueryTimer&) = delete;
+    QueryTimer& operator=(const QueryTimer&) = delete;
+
+private:
+#if DELPATHOPT_METRICS
+    static int& depth() {
+        static thread_local int nesting = 0;
+        return nesting;
+    }
+
+    bool outermost;
+    QueryKind kind = QueryKind::DeliveryPlan;
+    int origin = -1;
+    chrono::steady_clock::time_point started;
+#endif
+};
+
+/*
+ * Dijkstra main loop, generic over the queue backend
+ * @param g: Graph snapshot to search
+ * @param src: Origin index
+ * @param space: Labels to fill (reset by this call)
+ * @param pq: Queue backend to use
+ * @param stop: Called as stop(u, d) when u is settled at distance d;
+ *              returning true ends the search
+ * @return: Number of vertices settled
+ */
+template <class Queue, class Stop>
+int dijkstraLoop(const CSRGraph& g, int src, SearchSpace& space, Queue& pq, Stop stop) {
+    space.reset(g.vertexCount());
+    pq.reset(g.vertexCount(), g.maxCost);
+    space.set(src, 0, -1);
+    pq.push(0, src);
+
+    int settled = 0;
+    uint64_t pushes = 1, stale = 0, relaxed = 0; // Instrumentation counters
+    SimdLevel simd = activeSimdLevel();
+    while (!pq.empty()) {
+        pair<int, int> top = pq.pop();
+        int d = top.first;  // Current distance
+        int u = top.second; // Current vertex
+
+        // Skip if we've already found a better path
+        if (d > space.distance(u)) {
+            stale++;
+            continue;
+        }
+        settled++;
+
+        // Early exit once the caller has everything it needs
+        if (stop(u, d)) break;
+
+        // Explore all neighbors
+        int first = g.offsets[u], last = g.offsets[u + 1];
+        relaxed += last - first;
+        if (simd != SimdLevel::Scalar && last - first >= SIMD_MIN_DEGREE) {
+            // Hub: a vector kernel picks the few edges worth relaxing
+            int picked[SIMD_CHUNK];
+            for (int chunk = first; chunk < last; chunk += SIMD_CHUNK) {
+                int count = improvingEdges(simd, g, chunk, min(last, chunk + SIMD_CHUNK), space, d, picked);
+                for (int k = 0; k < count; ++k) {
+                    int v = g.targets[picked[k]];
+                    int cost = g.costs[picked[k]];
+                    if (space.distance(v) > d + cost) {
+                        space.set(v, d + cost, u);
+                        pq.push(d + cost, v);
+                        pushes++;
+                    }
+                }
+            }
+            continue;
+        }
+        for (int e = first; e < last; ++e) {
+            int v = g.targets[e];     // Neighbor index
+            int cost = g.costs[e];    // Edge cost
+            
+            // Relaxation step
+            if (space.distance(v) > d + cost) {
+                space.set(v, d + cost, u); // Update distance and predecessor
+                pq.push(d + cost, v);      // Add to queue
+                pushes++;
+            }
+        }
+    }
+    recordSearch(pushes, stale, relaxed, settled);
+    return settled;
+}
+
+/*
+ * Runs Dijkstra with the requested queue backend until stop(u, d) holds
+ * @param g: Graph snapshot to search
+ * @param src: Origin index
+ * @param kind: Queue backend (HeapKind::Auto picks from the cost range)
+ * @param ws: Workspace whose forward labels receive the result
+ * @param stop: Early-termination predicate, see dijkstraLoop
+ * @return: Number of vertices settled
+ */
+template <class Stop>
+int runDijkstraUntil(const CSRGraph& g, int src, HeapKind kind, QueryWorkspace& ws, Stop stop) {
+    switch (resolveHeapKind(kind, g)) {
+        case HeapKind::Dial:
+            return dijkstraLoop(g, src, ws.forward, ws.dial, stop);
+        case HeapKind::Radix:
+            return dijkstraLoop(g, src, ws.forward, ws.radix, stop);
+        case HeapKind::QuaternaryIndexed:
+            return dijkstraLoop(g, src, ws.forward, ws.quaternary, stop);
+        case HeapKind::Binary:
+        default:
+            return dijkstraLoop(g, src, ws.forward, ws.binary, stop);
+    }
+}
+
+/*
+ * Runs Dijkstra with the requested queue backend
+ * @param g: Graph snapshot to search
+ * @param src: Origin index
+ * @param dst: Stop once this vertex is settled (-1 to settle everything)
+ * @param kind: Queue backend (HeapKind::Auto picks from the cost range)
+ * @param ws: Workspace whose forward labels receive the result
+ * @return: Number of vertices settled
+ */
+inline int runDijkstra(const CSRGraph& g, int src, int dst, HeapKind kind, QueryWorkspace& ws) {
+    return runDijkstraUntil(g, src, kind, ws, [dst](int u, int) { return u == dst; });
+}
+
+/*
+ * Single-source Dijkstra over a CSR snapshot
+ * @param g: Graph snapshot to search
+ * @param src: Origin index
+ * @param kind: Priority queue backend
+ * @param ws: Workspace to run in
+ * @return: Distance to every vertex (numeric_limits<int>::max() if unreachable)
+ */
+inline vector<int> dijkstraDistances(const CSRGraph& g, int src, HeapKind kind, QueryWorkspace& ws) {
+    runDijkstra(g, src, -1, kind, ws);
+
+    // Expand the sparse labels into a dense array
+    vector<int> dist(g.vertexCount(), numeric_limits<int>::max());
+    for (int v : ws.forward.touchedVertices()) dist[v] = ws.forward.distance(v);
+    return dist;
+}
+
+/*
+ * Single-source Dijkstra in a temporary workspace
+ * @param g: Graph snapshot to search
+ * @param src: Origin index
+ * @param kind: Priority queue backend
+ */
+inline vector<int> dijkstraDistances(const CSRGraph& g, int src, HeapKind kind = HeapKind::Auto) {
+    QueryWorkspace ws;
+    return dijkstraDistances(g, src, kind, ws);
+}
+
+/*
+ * LandmarkTable struct
+ * Precomputed ALT (A*, Landmarks, Triangle inequality) distance tables.
+ * For every landmark L and vertex v, |d(L, t) - d(L, v)| is a lower bound
+ * on d(v, t) because routes are symmetric. Distances are stored vertex-major
+ * so one vertex's K entries share a cache line during a query.
+ */
+struct LandmarkTable {
+    int vertexCount = 0;          // Vertices covered by the tables
+    uint64_t fingerprint = 0;     // Hash of the graph the tables were built on
+    vector<int> landmarks;        // Landmark vertex indices
+    vector<int> distances;        // distances[v * K + i] = d(landmarks[i], v)
+
+    // Number of landmarks K
+    int landmarkCount() const { return landmarks.size(); }
+
+    /*
+     * Computes a stable hash of a graph snapshot so tables are only reused
+     * on the exact graph version they were built for (FNV-1a)
+     */
+    static uint64_t fingerprintOf(const CSRGraph& g) {
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&h](const auto& values) {
+            for (int x : values) {
+                h ^= (uint32_t)x;
+                h *= 1099511628211ULL;
+            }
+        };
+        mix(g.offsets);
+        mix(g.targets);
+        mix(g.costs);
+        return h;
+    }
+
+    /*
+     * Picks K landmarks by farthest-point selection and runs Dijkstra from
+     * each one. Unreachable vertices count as infinitely far, so every
+     * connected component eventually receives a landmark.
+     * @param g: Graph snapshot to preprocess
+     * @param live: Whether each vertex is a live (non-tombstoned) location
+     * @param k: Number of landmarks to select
+     */
+    static LandmarkTable build(const CSRGraph& g, const vector<bool>& live, int k) {
+        const int INF = numeric_limits<int>::max();
+        LandmarkTable table;
+        int n = g.vertexCount();
+        table.vertexCount = n;
+        table.fingerprint = fingerprintOf(g);
+
+        // Closest-landmark distance per vertex, drives the farthest-point choice
+        vector<int> nearest(n, INF);
+        QueryWorkspace ws;
+        vector<vector<int>> rows;
+        int next = -1;
+        for (int v = 0; v < n && next < 0; ++v) {
+            if (live[v]) next = v;
+        }
+
+        while (next >= 0 && (int)table.landmarks.size() < k) {
+            table.landmarks.push_back(next);
+            rows.push_back(dijkstraDistances(g, next, HeapKind::Auto, ws));
+            const vector<int>& row = rows.back();
+
+            // Next landmark: live vertex farthest from all chosen so far
+            next = -1;
+            int farthest = 0;
+            for (int v = 0; v < n; ++v) {
+                nearest[v] = min(nearest[v], row[v]);
+                if (live[v] && nearest[v] > farthest) {
+                    farthest = nearest[v];
+                    next = v;
+                }
+            }
+        }
+
+        // Interleave the per-landmark rows into the vertex-major table
+        int count = table.landmarks.size();
+        table.distances.resize((size_t)n * count);
+        for (int i = 0; i < count; ++i) {
+            for (int v = 0; v < n; ++v) {
+                table.distances[(size_t)v * count + i] = rows[i][v];
+            }
+        }
+        return table;
+    }
+
+    /*
+     * Triangle-inequality lower bound on d(v, t)
+     * @param v: Vertex being estimated
+     * @param t: Search target
+     */
+    int lowerBound(int v, int t) const {
+        const int INF = numeric_limits<int>::max();
+        int count = landmarks.size();
+        const int* dv = &distances[(size_t)v * count];
+        const int* dt = &distances[(size_t)t * count];
+        int best = 0;
+        for (int i = 0; i < count; ++i) {
+            // A landmark that cannot reach both vertices gives no bound
+            if (dv[i] == INF || dt[i] == INF) continue;
+            best = max(best, abs(dt[i] - dv[i]));
+        }
+        return best;
+    }
+
+    /*
+     * Writes the tables to a binary file
+     * @param path: Output file path
+     * @return: True on success
+     */
+    bool save(const string& path) const {
+        ofstream out(path, ios::binary);
+        if (!out) return false;
+        uint32_t header[3] = { LANDMARK_FILE_MAGIC, LANDMARK_FILE_VERSION, (uint32_t)landmarkCount() };
+        out.write((const char*)header, sizeof(header));
+        out.write((const char*)&vertexCount, sizeof(vertexCount));
+        out.write((const char*)&fingerprint, sizeof(fingerprint));
+        out.write((const char*)landmarks.data(), landmarks.size() * sizeof(int));
+        out.write((const char*)distances.data(), distances.size() * sizeof(int));
+        return (bool)out;
+    }
+
+    /*
+     * Reads tables written by save()
+     * @param path: Input file path
+     * @param table: Receives the loaded tables
+     * @return: True if the file was read and has a valid header
+     */
+    static bool load(const string& path, LandmarkTable& table) {
+        ifstream in(path, ios::binary);
+        if (!in) return false;
+        uint32_t header[3];
+        if (!in.read((char*)header, sizeof(header))) return false;
+        if (header[0] != LANDMARK_FILE_MAGIC || header[1] != LANDMARK_FILE_VERSION) return false;
+
+        LandmarkTable loaded;
+        in.read((char*)&loaded.vertexCount, sizeof(loaded.vertexCount));
+        in.read((char*)&loaded.fingerprint, sizeof(loaded.fingerprint));
+        if (!in || loaded.vertexCount < 0) return false;
+
+        // The header's counts must match the bytes that follow exactly,
+        // checked before anything is allocated for them
+        streamoff body = in.tellg();
+        in.seekg(0, ios::end);
+        streamoff size = in.tellg();
+        in.seekg(body);
+        if (!in || size < body) return false;
+        uint64_t values = (uint64_t)(size - body) / sizeof(int); // Ints left in the file
+        uint64_t count = header[2];
+        if ((uint64_t)(size - body) % sizeof(int) != 0 || count > values) return false;
+        if (count != 0 && (uint64_t)loaded.vertexCount != (values - count) / count) return false;
+        if (count * (1 + (uint64_t)loaded.vertexCount) != values) return false;
+
+        loaded.landmarks.resize(count);
+        loaded.distances.resize((size_t)loaded.vertexCount * count);
+        in.read((char*)loaded.landmarks.data(), loaded.landmarks.size() * sizeof(int));
+        in.read((char*)loaded.distances.data(), loaded.distances.size() * sizeof(int));
+        if (!in) return false;
+        for (int l : loaded.landmarks) {
+            if (l < 0 || l >= loaded.vertexCount) return false;
+        }
+        table = move(loaded);
+        return true;
+    }
+
+    static const uint32_t LANDMARK_FILE_MAGIC = 0x4B4D4C44;  // "DLMK"
+    static const uint32_t LANDMARK_FILE_VERSION = 1;
+};
+
+/*
+ * ContractionHierarchy class
+ * Preprocessed speed-up structure for point-to-point queries on a static
+ * graph. Vertices are contracted one at a time in order of importance,
+ * adding shortcut edges that preserve shortest-path distances among the
+ * remaining vertices. A query is then a bidirectional Dijkstra that only
+ * relaxes edges leading to higher-ranked vertices, which settles a tiny
+ * fraction of the graph. Routes are symmetric, so one upward graph serves
+ * both the forward and the backward search.
+ */
+class ContractionHierarchy {
+private:
+    // Edge of the graph being contracted (original route or shortcut)
+    struct Arc {
+        int to;      // Neighbor index
+        int cost;    // Edge cost
+        int middle;  // Contracted vertex bridged by a shortcut, -1 if original
+    };
+
+    // Upward graph in CSR form: edges from each vertex to higher-ranked ones
+    vector<int> upOffsets;
+    vector<int> upTargets;
+    vector<int> upCosts;
+    vector<int> upMiddle;
+
+    // Contraction position of each vertex (higher = more important)
+    vector<int> rank;
+
+    // Number of shortcut edges added during preprocessing
+    int shortcuts;
+
+    // Scratch state for the witness searches run during preprocessing
+    struct WitnessSearch {
+        vector<int> dist;
+        vector<int> touched;
+        vector<char> isTarget; // Neighbors whose witness distance is wanted
+        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+    };
+
+    // Shortcut u-w bridging a contracted vertex, pending insertion
+    struct Shortcut {
+        int from;
+        int to;
+        int cost;
+    };
+
+    // Maximum vertices a single witness search may settle (a missed witness
+    // only costs an unnecessary shortcut, never a wrong distance)
+    static const int WITNESS_SETTLE_LIMIT = 100;
+
+    /*
+     * Bounded Dijkstra from src over uncontracted vertices, skipping the
+     * vertex being contracted. Leaves distances in ws.dist.
+     * @param arcs: Current contraction graph
+     * @param contracted: Contraction flag per vertex
+     * @param src: Witness search origin
+     * @param skip: Vertex being contracted
+     * @param limit: Distance beyond which no witness is useful
+     * @param maxSettled: Search effort cap
+     * @param targets: Number of flagged targets; the search ends once all are settled
+     */
+    static void witnessSearch(const vector<vector<Arc>>& arcs, const vector<bool>& contracted,
+                              int src, int skip, int limit, int maxSettled, int targets,
+                              WitnessSearch& ws) {
+        const int INF = numeric_limits<int>::max();
+        for (int v : ws.touched) ws.dist[v] = INF;
+        ws.touched.clear();
+        while (!ws.pq.empty()) ws.pq.pop();
+
+        ws.dist[src] = 0;
+        ws.touched.push_back(src);
+        ws.pq.push(make_pair(0, src));
+        int settled = 0;
+        while (!ws.pq.empty() && settled < maxSettled) {
+            pair<int, int> top = ws.pq.top(); ws.pq.pop();
+            int d = top.first, u = top.second;
+            if (d > ws.dist[u]) continue;
+            if (d > limit) break;
+            settled++;
+            if (ws.isTarget[u] && --targets == 0) break;
+            for (const Arc& a : arcs[u]) {
+                if (a.to == skip || contracted[a.to]) continue;
+                if (ws.dist[a.to] > d + a.cost) {
+                    if (ws.dist[a.to] == INF) ws.touched.push_back(a.to);
+                    ws.dist[a.to] = d + a.cost;
+                    ws.pq.push(make_pair(ws.dist[a.to], a.to));
+                }
+            }
+        }
+    }
+
+    /*
+     * Finds the shortcuts needed to contract v without changing the graph
+     * @param arcs: Current contraction graph
+     * @param contracted: Contraction flag per vertex
+     * @param v: Vertex to contract
+     * @param needed: Receives the shortcuts (cleared first)
+     */
+    static void simulateContraction(const vector<vector<Arc>>& arcs, const vector<bool>& contracted,
+                                    int v, vector<Shortcut>& needed, WitnessSearch& ws) {
+        // Live neighbors of v and the largest cost leaving v
+        vector<Arc> around;
+        int maxCost = 0;
+        for (const Arc& a : arcs[v]) {
+            if (contracted[a.to]) continue;
+            around.push_back(a);
+            maxCost = max(maxCost, a.cost);
+        }
+
+        needed.clear();
+        for (size_t i = 0; i + 1 < around.size(); ++i) {
+            const Arc& in = around[i];
+
+            // Each unordered neighbor pair is checked once: only later neighbors
+            for (size_t j = i + 1; j < around.size(); ++j) ws.isTarget[around[j].to] = 1;
+            witnessSearch(arcs, contracted, in.to, v, in.cost + maxCost,
+                          WITNESS_SETTLE_LIMIT, around.size() - i - 1, ws);
+            for (size_t j = i + 1; j < around.size(); ++j) ws.isTarget[around[j].to] = 0;
+
+            for (size_t j = i + 1; j < around.size(); ++j) {
+                const Arc& out = around[j];
+                int via = in.cost + out.cost;
+                if (ws.dist[out.to] <= via) continue; // Witness path exists
+                Shortcut sc = { in.to, out.to, via };
+                needed.push_back(sc);
+            }
+        }
+    }
+
+    /*
+     * Inserts an arc, or lowers the cost of an existing arc to the same target
+     */
+    static void addOrImprove(vector<Arc>& list, int to, int cost, int middle) {
+        for (Arc& a : list) {
+            if (a.to != to) continue;
+            if (cost < a.cost) {
+                a.cost = cost;
+                a.middle = middle;
+            }
+            return;
+        }
+        Arc a = { to, cost, middle };
+        list.push_back(a);
+    }
+
+    /*
+     * Locates the upward edge joining two vertices
+     * @return: Edge index in the upward CSR arrays, or -1
+     */
+    int findUpEdge(int a, int b) const {
+        int lo = (rank[a] < rank[b]) ? a : b;
+        int hi = (lo == a) ? b : a;
+        for (int e = upOffsets[lo]; e < upOffsets[lo + 1]; ++e) {
+            if (upTargets[e] == hi) return e;
+        }
+        return -1;
+    }
+
+    /*
+     * Expands the hierarchy edge a-b into original routes, appending the
+     * vertices after a (up to and including b) to path
+     */
+    void unpack(int a, int b, vector<int>& path) const {
+        // Explicit stack of pending (from, to) segments, processed in order
+        vector<pair<int, int>> stack;
+        stack.push_back(make_pair(a, b));
+        while (!stack.empty()) {
+            pair<int, int> seg = stack.back(); stack.pop_back();
+            int e = findUpEdge(seg.first, seg.second);
+            int m = (e >= 0) ? upMiddle[e] : -1;
+            if (m < 0) {
+                path.push_back(seg.second);
+                continue;
+            }
+            // Push the second half first so the first half is expanded first
+            stack.push_back(make_pair(m, seg.second));
+            stack.push_back(make_pair(seg.first, m));
+        }
+    }
+
+public:
+    /*
+     * Builds the hierarchy from a graph snapshot
+     * @param g: Graph snapshot to preprocess
+     */
+    explicit ContractionHierarchy(const CSRGraph& g) : shortcuts(0) {
+        const int INF = numeric_limits<int>::max();
+        int n = g.vertexCount();
+
+        // Working copy with parallel routes merged and self-loops dropped
+        vector<vector<Arc>> arcs(n);
+        for (int u = 0; u < n; ++u) {
+            for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+                if ((int)g.targets[e] != u) addOrImprove(arcs[u], g.targets[e], g.costs[e], -1);
+            }
+        }
+
+        WitnessSearch ws;
+        ws.dist.assign(n, INF);
+        ws.isTarget.assign(n, 0);
+        vector<bool> contracted(n, false);
+        vector<int> deletedNeighbors(n, 0);
+        vector<vector<Arc>> upward(n);
+        rank.assign(n, 0);
+
+        // Importance: edge difference plus contracted-neighbor count
+        vector<Shortcut> pending;
+        auto priority = [&](int v) {
+            int degree = 0;
+            for (const Arc& a : arcs[v]) {
+                if (!contracted[a.to]) degree++;
+            }
+            simulateContraction(arcs, contracted, v, pending, ws);
+            return (int)pending.size() - degree + deletedNeighbors[v];
+        };
+
+        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> order;
+        for (int v = 0; v < n; ++v) order.push(make_pair(priority(v), v));
+
+        int position = 0;
+        while (!order.empty()) {
+            int v = order.top().second; order.pop();
+
+            // Lazy update: re-evaluate, and defer if v is no longer the minimum
+            int p = priority(v);
+            if (!order.empty() && p > order.top().first) {
+                order.push(make_pair(p, v));
+                continue;
+            }
+
+            // Insert the shortcuts found while re-evaluating v
+            for (const Shortcut& sc : pending) {
+                addOrImprove(arcs[sc.from], sc.to, sc.cost, v);
+                addOrImprove(arcs[sc.to], sc.from, sc.cost, v);
+            }
+            shortcuts += pending.size();
+            contracted[v] = true;
+            rank[v] = position++;
+
+            // Remaining arcs of v all lead upward; detach them from neighbors
+            for (const Arc& a : arcs[v]) {
+                if (contracted[a.to]) continue;
+                upward[v].push_back(a);
+                deletedNeighbors[a.to]++;
+            }
+            vector<Arc>().swap(arcs[v]);
+        }
+
+        // Pack the upward graph into CSR arrays
+        upOffsets.assign(n + 1, 0);
+        for (int v = 0; v < n; ++v) upOffsets[v + 1] = upOffsets[v] + upward[v].size();
+        upTargets.resize(upOffsets[n]);
+        upCosts.resize(upOffsets[n]);
+        upMiddle.resize(upOffsets[n]);
+        for (int v = 0; v < n; ++v) {
+            int e = upOffsets[v];
+            for (const Arc& a : upward[v]) {
+                upTargets[e] = a.to;
+                upCosts[e] = a.cost;
+                upMiddle[e] = a.middle;
+                ++e;
+            }
+        }
+    }
+
+    // Number of shortcut edges added during preprocessing
+    int shortcutCount() const { return shortcuts; }
+
+    /*
+     * Exhaustive upward search from src: afterwards space holds the exact
+     * hierarchy distance to every vertex in src's upward search space.
+     * Building block of the bucket-based many-to-many matrix computation.
+     * @param src: Origin index
+     * @param space: Labels to fill (reset by this call)
+     * @param pq: Queue to run with
+     */
+    void upwardSearch(int src, SearchSpace& space, BinaryHeapQueue& pq) const {
+        int n = rank.size();
+        space.reset(n);
+        pq.reset(n, 0);
+        space.set(src, 0, -1);
+        pq.push(0, src);
+        while (!pq.empty()) {
+            pair<int, int> top = pq.pop();
+            int d = top.first, u = top.second;
+            if (d > space.distance(u)) continue;
+            for (int e = upOffsets[u]; e < upOffsets[u + 1]; ++e) {
+                int v = upTargets[e];
+                if (space.distance(v) > d + upCosts[e]) {
+                    space.set(v, d + upCosts[e], u);
+                    pq.push(d + upCosts[e], v);
+                }
+            }
+        }
+    }
+
+    /*
+     * Bidirectional upward search between two vertices
+     * @param src: Origin index
+     * @param dst: Destination index
+     * @param path: Receives the unpacked vertex sequence src..dst
+     * @param settled: Receives the number of vertices settled
+     * @param ws: Workspace to run in
+     * @return: Shortest distance, or numeric_limits<int>::max() if unreachable
+     */
+    int query(int src, int dst, vector<int>& path, int& settled, QueryWorkspace& ws) const {
+        const int INF = numeric_limits<int>::max();
+        int n = rank.size();
+        SearchSpace* space[2] = { &ws.forward, &ws.backward };
+        BinaryHeapQueue* pq = ws.sides;
+        for (int side = 0; side < 2; ++side) {
+            space[side]->reset(n);
+            pq[side].reset(n, 0);
+        }
+        space[0]->set(src, 0, -1); pq[0].push(0, src);
+        space[1]->set(dst, 0, -1); pq[1].push(0, dst);
+
+        int best = INF, meet = -1;
+        settled = 0;
+        while (!pq[0].empty() || !pq[1].empty()) {
+            // Advance the side with the smaller key; stop once neither can improve
+            int side = (pq[1].empty() || (!pq[0].empty() && pq[0].peekKey() <= pq[1].peekKey())) ? 0 : 1;
+            if (pq[side].peekKey() >= best) break;
+
+            pair<int, int> entry = pq[side].pop();
+            int d = entry.first, u = entry.second;
+            if (d > space[side]->distance(u)) continue;
+            settled++;
+
+            // Candidate meeting point
+            int other = space[1 - side]->distance(u);
+            if (other != INF && d + other < best) {
+                best = d + other;
+                meet = u;
+            }
+
+            for (int e = upOffsets[u]; e < upOffsets[u + 1]; ++e) {
+                int v = upTargets[e];
+                if (space[side]->distance(v) > d + upCosts[e]) {
+                    space[side]->set(v, d + upCosts[e], u);
+                    pq[side].push(d + upCosts[e], v);
+                }
+            }
+        }
+
+        path.clear();
+        if (best == INF) return INF;
+
+        // Hierarchy-level path: src .. meet .. dst
+        vector<int> coarse;
+        for (int v = meet; v != -1; v = space[0]->predecessor(v)) coarse.push_back(v);
+        reverse(coarse.begin(), coarse.end());
+        for (int v = space[1]->predecessor(meet); v != -1; v = space[1]->predecessor(v)) coarse.push_back(v);
+
+        // Replace every shortcut by the original routes it represents
+        path.push_back(src);
+        for (size_t i = 1; i < coarse.size(); ++i) {
+            unpack(coarse[i - 1], coarse[i], path);
+        }
+        return best;
+    }
+};
+
+/*
+ * Search strategies available for point-to-point queries
+ */
+enum class SearchMode {
+    Dijkstra,      // Unidirectional Dijkstra with early termination
+    Bidirectional, // Forward and backward Dijkstra meeting in the middle
+    AStar,         // Goal-directed search guided by a coordinate heuristic
+    ALT,           // Goal-directed search guided by landmark lower bounds
+    ContractionHierarchy // Bidirectional upward search on a preprocessed hierarchy
+};
+
+/*
+ * GeoPoint struct
+ * Geographic position of a location in decimal degrees
+ */
+struct GeoPoint {
+    double lat = 0.0;
+    double lon = 0.0;
+};
+
+/*
+ * A* heuristic: lower bound on the cost between two positioned locations.
+ * Must never overestimate the true route cost, or A* may miss the optimum.
+ */
+typedef function<int(const GeoPoint& from, const GeoPoint& to)> Heuristic;
+
+/*
+ * Builds the default A* heuristic: great-circle distance divided by the
+ * fastest possible travel speed, rounded down so it stays admissible
+ * @param maxSpeedKmPerCost: Kilometres covered per unit of route cost at
+ *                           top speed (e.g. 2.0 for 120 km/h with minutes)
+ */
+inline Heuristic greatCircleHeuristic(double maxSpeedKmPerCost) {
+    return [maxSpeedKmPerCost](const GeoPoint& a, const GeoPoint& b) {
+        const double EARTH_RADIUS_KM = 6371.0;
+        const double TO_RAD = 3.14159265358979323846 / 180.0;
+        double dLat = (b.lat - a.lat) * TO_RAD;
+        double dLon = (b.lon - a.lon) * TO_RAD;
+
+        // Haversine formula
+        double h = sin(dLat / 2) * sin(dLat / 2) +
+                   cos(a.lat * TO_RAD) * cos(b.lat * TO_RAD) * sin(dLon / 2) * sin(dLon / 2);
+        double km = 2 * EARTH_RADIUS_KM * asin(min(1.0, sqrt(h)));
+        return (int)floor(km / maxSpeedKmPerCost);
+    };
+}
+
+/*
+ * Status enum
+ * Outcome of a mutation, preprocessing or persistence call. Methods report
+ * through this instead of printing so callers choose how (or whether) to
+ * show it.
+ */
+enum class Status {
+    Ok,              // Call succeeded
+    NotFound,        // A named location (or the landmark tables) does not exist
+    AlreadyExists,   // Location name is already taken
+    InvalidArgument, // Parameter out of range
+    NothingToDo,     // Call had no effect (e.g. nothing to compact)
+    IoError,         // File could not be read or written
+    StaleData        // Loaded data was built for a different graph
+};
+
+/*
+ * PathResult struct
+ * Outcome of a point-to-point shortest path query
+ */
+struct PathResult {
+    Status status = Status::Ok; // NotFound if either location name is unknown
+    bool found = false;      // True if the destination is reachable
+    int eta = 0;             // Total cost of the path (valid if found)
+    vector<string> stops;    // Stops from origin to destination, inclusive
+    int settledCount = 0;    // Vertices settled by the search
+};
+
+/*
+ * ShortestPathTree struct
+ * Full single-source result for one origin (delivery plan or batch query)
+ */
+struct ShortestPathTree {
+    string origin;             // Origin location name
+    bool found = false;        // False if the origin location does not exist
+    vector<int> distances;     // Distance per location index (numeric_limits<int>::max()
+                               // if unreachable)
+    vector<int> predecessors;  // Previous stop per location index (-1 at origin/unreached);
+                               // empty unless requested
+};
+
+/*
+ * ServiceArea struct
+ * Locations within a travel-cost limit of one origin (an isochrone)
+ */
+struct ServiceArea {
+    string origin;                  // Origin location name
+    bool found = false;             // False if the origin location does not exist
+    int limit = 0;                  // Largest distance included
+    vector<pair<int, int>> reached; // (location index, distance), nearest first
+};
+
+/*
+ * ImportReport struct
+ * Outcome of a bulk graph import
+ */
+struct ImportReport {
+    Status status = Status::Ok;  // IoError if an input file could not be mapped
+    int locationsAdded = 0;      // New locations, including route endpoints
+    long long routesAdded = 0;   // Bidirectional routes added
+    long long linesSkipped = 0;  // Blank, comment, duplicate or malformed lines
+    double seconds = 0;          // Wall time of the whole import
+
+    // Load throughput (routes per second)
+    double edgesPerSecond() const { return seconds > 0 ? routesAdded / seconds : 0; }
+};
+
+/*
+ * RouteSimulation struct
+ * Breadth-first visit order of a simulated delivery round
+ */
+struct RouteSimulation {
+    string origin;             // Origin location name
+    bool found = false;        // False if the origin location does not exist
+    vector<int> visitOrder;    // Location indices in the order they are visited
+    vector<int> levels;        // Hop count per location index (-1 if unreachable)
+};
+
+/*
+ * BfsMode enum
+ * How simulateDelivery() explores the network
+ */
+enum class BfsMode {
+    Sequential,          // Queue-based BFS; deterministic visit order
+    DirectionOptimizing  // Parallel top-down/bottom-up BFS; visit order is
+                         // grouped by level but unordered within a level
+};
+
+/*
+ * DistanceMatrix struct
+ * Travel costs between every source and target, stored row-major in one
+ * contiguous buffer (row = source, column = target)
+ */
+struct DistanceMatrix {
+    int rows = 0;           // Number of sources
+    int cols = 0;           // Number of targets
+    vector<int> data;       // rows * cols costs (numeric_limits<int>::max() if unreachable)
+
+    // Cost from source i to target j
+    int at(int i, int j) const { return data[(size_t)i * cols + j]; }
+};
+
+/*
+ * DeliveryTour struct
+ * Stop sequence for one driver, from planDeliveryTour()
+ */
+struct DeliveryTour {
+    Status status = Status::Ok;  // NotFound if the origin is unknown
+    vector<string> stops;        // Stops in delivery order (origin excluded)
+    vector<int> arrivals;        // ETA at each stop, counted from the origin
+    vector<string> skipped;      // Unknown stops and stops with no route from the origin
+    int eta = 0;                 // Total travel time (back at the origin for a round trip)
+    int moves = 0;               // Improving 2-opt / Or-opt moves applied
+    double seconds = 0;          // Wall time, including the distance matrix
+};
+
+/*
+ * Runs body(worker, i) for every i in [0, count) on up to `threads` threads.
+ * Items are handed out through a shared atomic counter, so uneven item
+ * costs still balance; worker is a stable id in [0, threads) for indexing
+ * per-thread state such as workspaces.
+ * @param count: Number of work items
+ * @param threads: Worker threads to use (0 = hardware concurrency)
+ * @param body: Callable taking (int worker, int item)
+ */
+template <class Body>
+void parallelFor(int count, int threads, Body body) {
+    if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+    threads = max(1, min(threads, count));
+
+    atomic<int> next(0);
+    auto work = [&](int worker) {
+        for (int i = next++; i < count; i = next++) body(worker, i);
+    };
+
+    // The calling thread acts as worker 0
+    vector<thread> pool;
+    for (int w = 1; w < threads; ++w) pool.emplace_back(work, w);
+    work(0);
+    for (auto& t : pool) t.join();
+}
+
+/*
+ * SpinBarrier class
+ * Reusable barrier for a fixed team of threads that meet many times per
+ * second, where sleeping on a condition variable would cost more than the
+ * phases themselves
+ */
+class SpinBarrier {
+private:
+    const int parties;            // Threads that must arrive
+    atomic<int> waiting;          // Threads arrived in the current generation
+    atomic<int> generation;       // Bumped each time the barrier opens
+
+public:
+    explicit SpinBarrier(int count) : parties(count), waiting(0), generation(0) {}
+
+    // Blocks until all parties have called wait() for this generation
+    void wait() {
+        int gen = generation.load(memory_order_acquire);
+        if (waiting.fetch_add(1, memory_order_acq_rel) + 1 == parties) {
+            waiting.store(0, memory_order_relaxed);
+            generation.fetch_add(1, memory_order_release);
+        } else {
+            while (generation.load(memory_order_acquire) == gen) this_thread::yield();
+        }
+    }
+};
+
+/*
+ * Parallel delta-stepping single-source shortest paths. Tentative distances
+ * are grouped into buckets of width delta; all vertices of the lowest bucket
+ * are relaxed in parallel, first repeatedly along light edges (cost <= delta,
+ * which can refill the same bucket) and then once along heavy edges. Labels
+ * are lowered with compare-and-swap, so the result is exactly the Dijkstra
+ * distance array. Requires non-negative costs.
+ * @param g: Graph snapshot to search
+ * @param src: Origin index
+ * @param delta: Bucket width (small = Dijkstra-like, large = Bellman-Ford-like)
+ * @param threads: Worker threads (0 = hardware concurrency)
+ * @return: Distance per vertex (numeric_limits<int>::max() if unreachable)
+ */
+inline vector<int> deltaSteppingDistances(const CSRGraph& g, int src, int delta, int threads) {
+    const int INF = numeric_limits<int>::max();
+    const int CHUNK = 256; // Vertices claimed per counter increment
+    int n = g.vertexCount();
+    if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+    delta = max(1, delta);
+
+    // Every tentative label lies within maxCost + delta of the current
+    // bucket, so this many cyclic slots never alias two live buckets
+    int slots = g.maxCost / delta + 2;
+    vector<vector<vector<int>>> buckets(threads, vector<vector<int>>(slots));
+    vector<atomic<int>> dist(n);
+
+    // Phase state, written by worker 0 between barriers
+    vector<int> frontier, settled;
+    vector<int> frontierMark(n, -1), settledMark(n, -1);
+    const vector<int>* work = nullptr;
+    bool heavy = false, done = false, inBucket = false;
+    int bucket = 0, round = 0;
+    atomic<int> next(0);
+    SpinBarrier barrier(threads);
+
+    auto relax = [&](int worker, int v, int nd) {
+        int old = dist[v].load(memory_order_relaxed);
+        while (nd < old) {
+            if (dist[v].compare_exchange_weak(old, nd, memory_order_relaxed)) {
+                buckets[worker][(nd / delta) % slots].push_back(v);
+                return;
+            }
+        }
+    };
+
+    // Serial step: choose the next phase and its work list
+    auto plan = [&]() {
+        if (!inBucket) {
+            int found = -1;
+            for (int b = bucket; b < bucket + slots && found < 0; ++b) {
+                for (int t = 0; t < threads && found < 0; ++t) {
+                    if (!buckets[t][b % slots].empty()) found = b;
+                }
+            }
+            if (found < 0) { done = true; return; }
+            bucket = found;
+            settled.clear();
+            inBucket = true;
+        }
+
+        // Gather the bucket, dropping entries whose label has since moved
+        // to an earlier bucket and duplicates of this round
+        frontier.clear();
+        round++;
+        for (int t = 0; t < threads; ++t) {
+            vector<int>& slot = buckets[t][bucket % slots];
+            for (int v : slot) {
+                if (dist[v].load(memory_order_relaxed) / delta != bucket || frontierMark[v] == round) continue;
+                frontierMark[v] = round;
+                frontier.push_back(v);
+                if (settledMark[v] != bucket) {
+                    settledMark[v] = bucket;
+                    settled.push_back(v);
+                }
+            }
+            slot.clear();
+        }
+        if (!frontier.empty()) {
+            work = &frontier;
+            heavy = false;
+        } else {
+            work = &settled; // Bucket is final: relax its heavy edges once
+            heavy = true;
+            inBucket = false;
+            bucket++;
+        }
+        next.store(0, memory_order_relaxed);
+    };
+
+    auto team = [&](int worker) {
+        for (int v = worker; v < n; v += threads) dist[v].store(INF, memory_order_relaxed);
+        barrier.wait();
+        if (worker == 0) {
+            dist[src].store(0, memory_order_relaxed);
+            buckets[0][0].push_back(src);
+        }
+        while (true) {
+            if (worker == 0) plan();
+            barrier.wait();
+            if (done) break;
+            const vector<int>& items = *work;
+            int count = items.size();
+            for (int begin = next.fetch_add(CHUNK); begin < count; begin = next.fetch_add(CHUNK)) {
+                int end = min(count, begin + CHUNK);
+                for (int k = begin; k < end; ++k) {
+                    int u = items[k];
+                    int du = dist[u].load(memory_order_relaxed);
+                    for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+                        if (((int)g.costs[e] > delta) == heavy) relax(worker, g.targets[e], du + g.costs[e]);
+                    }
+                }
+            }
+            barrier.wait();
+        }
+    };
+
+    vector<thread> pool;
+    for (int w = 1; w < threads; ++w) pool.emplace_back(team, w);
+    team(0);
+    for (auto& t : pool) t.join();
+
+    vector<int> result(n);
+    for (int v = 0; v < n; ++v) result[v] = dist[v].load(memory_order_relaxed);
+    return result;
+}
+
+/*
+ * Parallel direction-optimizing BFS (Beamer et al.). Small frontiers expand
+ * top-down, claiming neighbors in an atomic visited bitmap. Once the
+ * frontier's edges outnumber a fraction of the unexplored ones, levels are
+ * computed bottom-up instead: every unvisited vertex scans its neighbors
+ * for a parent in the frontier and stops at the first hit, which skips most
+ * edges of the large middle levels. It switches back once the frontier
+ * shrinks again.
+ * @param g: Graph snapshot to search
+ * @param src: Origin index
+ * @param threads: Worker threads (0 = hardware concurrency)
+ * @param levels: Receives the hop count per vertex (-1 if unreachable)
+ * @param order: Receives the visited vertices, level by level
+ */
+inline void directionOptimizingBfs(const CSRGraph& g, int src, int threads,
+                                   vector<int>& levels, vector<int>& order) {
+    const int ALPHA = 14;   // Go bottom-up when frontier edges > unexplored / ALPHA
+    const int BETA = 24;    // Go top-down when frontier vertices < n / BETA
+    const int CHUNK = 256;  // Work items claimed per counter increment
+    int n = g.vertexCount();
+    int words = (n + 63) / 64;
+    if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+
+    levels.assign(n, -1);
+    order.clear();
+    vector<atomic<uint64_t>> visited(words);
+    vector<uint64_t> inFrontier(words);
+    for (auto& w : visited) w.store(0, memory_order_relaxed);
+
+    // Per-thread output of a step: next frontier and the edges it carries
+    vector<vector<int>> found(threads);
+    vector<long long> foundEdges(threads);
+
+    // Step state, written by worker 0 between barriers
+    vector<int> frontier(1, src);
+    long long frontierEdges = g.offsets[src + 1] - g.offsets[src];
+    long long unexploredEdges = g.edgeCount() - frontierEdges;
+    bool bottomUp = false, done = false;
+    int depth = 0;
+    atomic<int> next(0);
+    SpinBarrier barrier(threads);
+    levels[src] = 0;
+    visited[src / 64].store(1ULL << (src % 64), memory_order_relaxed);
+
+    // Serial step: publish the level just found and pick the next direction
+    auto plan = [&]() {
+        if (depth > 0) {
+            frontier.clear();
+            frontierEdges = 0;
+            for (int t = 0; t < threads; ++t) {
+                frontier.insert(frontier.end(), found[t].begin(), found[t].end());
+                frontierEdges += foundEdges[t];
+                found[t].clear();
+                foundEdges[t] = 0;
+            }
+            unexploredEdges -= frontierEdges;
+        }
+        order.insert(order.end(), frontier.begin(), frontier.end());
+        if (frontier.empty()) { done = true; return; }
+
+        if (!bottomUp && frontierEdges > unexploredEdges / ALPHA) bottomUp = true;
+        else if (bottomUp && (long long)frontier.size() * BETA < n) bottomUp = false;
+        if (bottomUp) {
+            fill(inFrontier.begin(), inFrontier.end(), 0);
+            for (int u : frontier) inFrontier[u / 64] |= 1ULL << (u % 64);
+        }
+        depth++;
+        next.store(0, memory_order_relaxed);
+    };
+
+    auto topDown = [&](int worker) {
+        int count = frontier.size();
+        for (int begin = next.fetch_add(CHUNK); begin < count; begin = next.fetch_add(CHUNK)) {
+            int end = min(count, begin + CHUNK);
+            for (int k = begin; k < end; ++k) {
+                int u = frontier[k];
+                for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+                    int v = g.targets[e];
+                    uint64_t bit = 1ULL << (v % 64);
+                    if (visited[v / 64].load(memory_order_relaxed) & bit) continue;
+                    if (visited[v / 64].fetch_or(bit, memory_order_relaxed) & bit) continue;
+                    levels[v] = depth;
+                    found[worker].push_back(v);
+                    foundEdges[worker] += g.offsets[v + 1] - g.offsets[v];
+                }
+            }
+        }
+    };
+
+    auto bottomUpStep = [&](int worker) {
+        int chunkWords = max(1, CHUNK / 64);
+        for (int begin = next.fetch_add(chunkWords); begin < words; begin = next.fetch_add(chunkWords)) {
+            int end = min(words, begin + chunkWords);
+            for (int w = begin; w < end; ++w) {
+                uint64_t seen = visited[w].load(memory_order_relaxed);
+                uint64_t claimed = 0;
+                for (int b = 0; b < 64; ++b) {
+                    int v = w * 64 + b;
+                    if (v >= n) break;
+                    if (seen & (1ULL << b)) continue;
+                    for (int e = g.offsets[v]; e < g.offsets[v + 1]; ++e) {
+                        int u = g.targets[e];
+                        if (inFrontier[u / 64] & (1ULL << (u % 64))) {
+                            claimed |= 1ULL << b;
+                            levels[v] = depth;
+                            found[worker].push_back(v);
+                            foundEdges[worker] += g.offsets[v + 1] - g.offsets[v];
+                            break;
+                        }
+                    }
+                }
+                // Only this thread scans word w in this step
+                if (claimed) visited[w].fetch_or(claimed, memory_order_relaxed);
+            }
+        }
+    };
+
+    auto team = [&](int worker) {
+        while (true) {
+            if (worker == 0) plan();
+            barrier.wait();
+            if (done) break;
+            if (bottomUp) bottomUpStep(worker);
+            else topDown(worker);
+            barrier.wait();
+        }
+    };
+
+    vector<thread> pool;
+    for (int w = 1; w < threads; ++w) pool.emplace_back(team, w);
+    team(0);
+    for (auto& t : pool) t.join();
+}
+
+/*
+ * VertexOrder enum
+ * Numbering of the CSR snapshot's vertices. Searches touch a location's
+ * neighbors right after the location itself, so numbering nearby locations
+ * next to each other keeps those accesses in the same cache lines. Results
+ * are always reported by location index, whatever the numbering.
+ */
+enum class VertexOrder {
+    Insertion,            // Vertex i is location i (no renumbering)
+    BFS,                  // Breadth-first order, one component after another
+    ReverseCuthillMcKee,  // Degree-ordered BFS reversed; keeps edges short
+    Hilbert               // Position along a Hilbert curve over the coordinates
+};
+
+/*
+ * Breadth-first vertex order. Each component is numbered contiguously from
+ * its first location; Cuthill-McKee starts each component at its lowest
+ * degree location, enqueues neighbors by ascending degree and reverses the
+ * result. Locations without routes (including tombstones) come last.
+ * @param adjList: Adjacency list to renumber
+ * @param byDegree: Produce the reverse Cuthill-McKee order instead of plain BFS
+ * @return: Location stored at each vertex
+ */
+inline vector<int> breadthFirstOrder(const vector<vector<pair<int, int>>>& adjList, bool byDegree) {
+    int n = adjList.size();
+    auto lowerDegree = [&](int a, int b) {
+        return adjList[a].size() != adjList[b].size() ? adjList[a].size() < adjList[b].size() : a < b;
+    };
+
+    vector<int> starts(n);
+    for (int u = 0; u < n; ++u) starts[u] = u;
+    if (byDegree) sort(starts.begin(), starts.end(), lowerDegree);
+
+    vector<int> order, isolated, neighbors;
+    order.reserve(n);
+    vector<char> seen(n, 0);
+    for (int s : starts) {
+        if (seen[s]) continue;
+        seen[s] = 1;
+        if (adjList[s].empty()) {
+            isolated.push_back(s);
+            continue;
+        }
+
+        // The order vector doubles as the BFS queue
+        order.push_back(s);
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            neighbors.clear();
+            for (const auto& p : adjList[order[head]]) {
+                if (!seen[p.first]) {
+                    seen[p.first] = 1;
+                    neighbors.push_back(p.first);
+                }
+            }
+            if (byDegree) sort(neighbors.begin(), neighbors.end(), lowerDegree);
+            order.insert(order.end(), neighbors.begin(), neighbors.end());
+        }
+    }
+    if (byDegree) reverse(order.begin(), order.end());
+    order.insert(order.end(), isolated.begin(), isolated.end());
+    return order;
+}
+
+/*
+ * Distance of cell (x, y) along a Hilbert curve filling a 2^16 x 2^16 grid
+ * @param x: Column in [0, 65535]
+ * @param y: Row in [0, 65535]
+ */
+inline uint64_t hilbertIndex(uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for (uint32_t s = 1u << 15; s > 0; s >>= 1) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += (uint64_t)s * s * ((3 * rx) ^ ry);
+
+        // Rotate the quadrant so the curve stays continuous
+        if (ry == 0) {
+            if (rx == 1) {
+                x = 0xFFFF - x;
+                y = 0xFFFF - y;
+            }
+            swap(x, y);
+        }
+    }
+    return d;
+}
+
+/*
+ * Hilbert curve vertex order over the bounding box of the known
+ * coordinates, so locations close on the map get close vertex numbers.
+ * Locations without coordinates follow in index order.
+ * @param coordinates: Position of every location
+ * @param known: Whether each location has a position
+ * @return: Location stored at each vertex, or empty if no position is known
+ */
+inline vector<int> hilbertOrder(const vector<GeoPoint>& coordinates, const vector<bool>& known) {
+    int n = coordinates.size();
+    double minLat = 90.0, maxLat = -90.0, minLon = 180.0, maxLon = -180.0;
+    for (int i = 0; i < n; ++i) {
+        if (!known[i]) continue;
+        minLat = min(minLat, coordinates[i].lat);
+        maxLat = max(maxLat, coordinates[i].lat);
+        minLon = min(minLon, coordinates[i].lon);
+        maxLon = max(maxLon, coordinates[i].lon);
+    }
+    if (minLat > maxLat) return vector<int>();
+
+    const double CELLS = 65535.0;
+    double latScale = maxLat > minLat ? CELLS / (maxLat - minLat) : 0.0;
+    double lonScale = maxLon > minLon ? CELLS / (maxLon - minLon) : 0.0;
+    vector<pair<uint64_t, int>> keyed; // (curve position, location)
+    vector<int> unplaced;
+    for (int i = 0; i < n; ++i) {
+        if (!known[i]) {
+            unplaced.push_back(i);
+            continue;
+        }
+        uint32_t x = (uint32_t)((coordinates[i].lon - minLon) * lonScale);
+        uint32_t y = (uint32_t)((coordinates[i].lat - minLat) * latScale);
+        keyed.push_back(make_pair(hilbertIndex(x, y), i));
+    }
+    sort(keyed.begin(), keyed.end());
+
+    vector<int> order;
+    order.reserve(n);
+    for (const auto& k : keyed) order.push_back(k.second);
+    order.insert(order.end(), unplaced.begin(), unplaced.end());
+    return order;
+}
+
+/*
+ * Orders the stops of one delivery run over a symmetric cost matrix:
+ * nearest-neighbor construction, then best-improvement 2-opt (reverse a
+ * stretch) and Or-opt (move a run of up to three stops, either way round)
+ * until no move helps or the time budget runs out. Before each scan the
+ * matrix is copied into tour order, so a candidate move's delta reads
+ * contiguous rows and the per-row loops vectorize.
+ * @param cost: size x size row-major costs; node 0 is the fixed start and
+ *              node size - 1 the fixed end, every other node is a stop
+ * @param size: Number of nodes (at least 2)
+ * @param budgetSeconds: Time allowed for local search
+ * @param moves: Receives the number of improving moves applied
+ * @return: Node sequence from 0 to size - 1
+ */
+inline vector<int> orderTourStops(const vector<int>& cost, int size, double budgetSeconds, int& moves) {
+    const int n = size;
+    auto deadline = chrono::steady_clock::now() + chrono::duration<double>(budgetSeconds);
+
+    // Nearest-neighbor construction
+    vector<int> tour(1, 0);
+    vector<char> used(n, 0);
+    used[0] = used[n - 1] = 1;
+    for (int step = 1; step < n - 1; ++step) {
+        const int* row = &cost[(size_t)tour.back() * n];
+        int next = -1;
+        for (int v = 1; v < n - 1; ++v) {
+            if (!used[v] && (next < 0 || row[v] < row[next])) next = v;
+        }
+        used[next] = 1;
+        tour.push_back(next);
+    }
+    tour.push_back(n - 1);
+
+    vector<int> t((size_t)n * n); // Costs between tour positions
+    vector<int> link(n);          // link[j] = t[j][j + 1], the tour's own edges
+    vector<int> gain(n);
+    moves = 0;
+    while (chrono::steady_clock::now() < deadline) {
+        for (int a = 0; a < n; ++a) {
+            const int* from = &cost[(size_t)tour[a] * n];
+            int* to = &t[(size_t)a * n];
+            for (int b = 0; b < n; ++b) to[b] = from[tour[b]];
+        }
+        for (int j = 0; j + 1 < n; ++j) link[j] = t[(size_t)j * n + j + 1];
+
+        // Best move found in this scan
+        int bestGain = 0, kind = 0, bestI = 0, bestJ = 0, bestLength = 0;
+        auto consider = [&](int first, int last, int k, int i, int length) {
+            for (int j = first; j <= last; ++j) {
+                if (gain[j] > bestGain) {
+                    bestGain = gain[j];
+                    kind = k;
+                    bestI = i;
+                    bestJ = j;
+                    bestLength = length;
+                }
+            }
+        };
+
+        // 2-opt: reversing positions [i, j] swaps edges (i-1, i), (j, j+1)
+        // for (i-1, j), (i, j+1)
+        for (int i = 1; i + 2 < n; ++i) {
+            const int* before = &t[(size_t)(i - 1) * n];
+            const int* head = &t[(size_t)i * n];
+            int current = link[i - 1];
+            for (int j = i + 1; j + 1 < n; ++j) {
+                gain[j] = current + link[j] - before[j] - head[j + 1];
+            }
+            consider(i + 1, n - 2, 1, i, 0);
+        }
+
+        // Or-opt: run [i, i + length - 1] moves between positions j and j + 1
+        for (int length = 1; length <= 3; ++length) {
+            for (int i = 1; i + length < n; ++i) {
+                int last = i + length - 1;
+                const int* head = &t[(size_t)i * n];
+                const int* tail = &t[(size_t)last * n];
+                int removal = link[i - 1] + link[last] - t[(size_t)(i - 1) * n + last + 1];
+                for (int reversed = 0; reversed < 2; ++reversed) {
+                    const int* left = reversed ? tail : head;
+                    const int* right = reversed ? head : tail;
+                    for (int j = 0; j + 1 < n; ++j) {
+                        gain[j] = removal + link[j] - left[j] - right[j + 1];
+                    }
+                    consider(0, i - 2, 2 + reversed, i, length);
+                    consider(last + 1, n - 2, 2 + reversed, i, length);
+                }
+            }
+        }
+
+        if (bestGain <= 0) break; // Local optimum
+        moves++;
+        if (kind == 1) {
+            reverse(tour.begin() + bestI, tour.begin() + bestJ + 1);
+        } else {
+            vector<int> run(tour.begin() + bestI, tour.begin() + bestI + bestLength);
+            if (kind == 3) reverse(run.begin(), run.end());
+            tour.erase(tour.begin() + bestI, tour.begin() + bestI + bestLength);
+            int at = (bestJ < bestI) ? bestJ + 1 : bestJ + 1 - bestLength;
+            tour.insert(tour.begin() + at, run.begin(), run.end());
+        }
+    }
+    return tour;
+}
+
+/*
+ * CacheStats struct
+ * Counters of the single-source result cache, for sizing it
+ */
+struct CacheStats {
+    uint64_t hits = 0;         // Lookups answered from the cache
+    uint64_t misses = 0;       // Lookups that had to run a search
+    uint64_t evictions = 0;    // Entries dropped to stay under the memory cap
+    size_t entries = 0;        // Trees currently held
+    size_t bytes = 0;          // Memory held by those trees
+    size_t capacityBytes = 0;  // Memory cap (0 = cache disabled)
+};
+
+/*
+ * ResultCache class
+ * LRU cache of single-source shortest-path trees keyed by origin index.
+ * Every entry is stamped with the graph version it was computed on, and a
+ * lookup under a newer version drops it, so no mutation ever has to walk
+ * the cache. Safe to use from concurrent query threads.
+ */
+class ResultCache {
+private:
+    struct Entry {
+        int source;                             // Origin index
+        uint64_t version;                       // Graph version of the tree
+        shared_ptr<const ShortestPathTree> tree;
+        size_t bytes;                           // Memory charged to the entry
+    };
+
+    list<Entry> entries;                        // Most recently used first
+    unordered_map<int, list<Entry>::iterator> bySource;
+    CacheStats stats;
+    mutable mutex lock;
+
+    // Unlinks an entry and releases its memory charge
+    void drop(list<Entry>::iterator it) {
+        stats.bytes -= it->bytes;
+        bySource.erase(it->source);
+        entries.erase(it);
+        stats.entries = entries.size();
+    }
+
+    // Evicts least recently used entries until the cap is met
+    void shrink() {
+        while (stats.bytes > stats.capacityBytes && !entries.empty()) {
+            drop(prev(entries.end()));
+            stats.evictions++;
+        }
+    }
+
+public:
+    explicit ResultCache(size_t capacityBytes) {
+        stats.capacityBytes = capacityBytes;
+    }
+
+    /*
+     * Looks up the tree of an origin, counting a hit or a miss
+     * @param source: Origin index
+     * @param version: Current graph version
+     * @return: The cached tree, or null if absent or computed on an older graph
+     */
+    shared_ptr<const ShortestPathTree> find(int source, uint64_t version) {
+        lock_guard<mutex> guard(lock);
+        auto it = bySource.find(source);
+        if (it == bySource.end() || it->second->version != version) {
+            if (it != bySource.end()) drop(it->second); // Stale: graph has changed
+            stats.misses++;
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, it->second); // Mark most recent
+        stats.hits++;
+        return it->second->tree;
+    }
+
+    /*
+     * Stores the tree of an origin, evicting older entries past the cap
+     * @param source: Origin index
+     * @param version: Graph version the tree was computed on
+     * @param tree: Tree to share with later lookups
+     */
+    void insert(int source, uint64_t version, shared_ptr<const ShortestPathTree> tree) {
+        size_t bytes = sizeof(ShortestPathTree) + tree->origin.capacity() +
+                       (tree->distances.capacity() + tree->predecessors.capacity()) * sizeof(int);
+        lock_guard<mutex> guard(lock);
+        if (bytes > stats.capacityBytes) return; // Would never fit
+        auto it = bySource.find(source);
+        if (it != bySource.end()) drop(it->second);
+        Entry entry = { source, version, move(tree), bytes };
+        entries.push_front(move(entry));
+        bySource[source] = entries.begin();
+        stats.bytes += bytes;
+        stats.entries = entries.size();
+        shrink();
+    }
+
+    /*
+     * Changes the memory cap (0 disables the cache and frees it)
+     * @param capacityBytes: New cap in bytes
+     */
+    void setCapacity(size_t capacityBytes) {
+        lock_guard<mutex> guard(lock);
+        stats.capacityBytes = capacityBytes;
+        shrink();
+    }
+
+    // Whether lookups are worth attempting
+    bool enabled() const {
+        lock_guard<mutex> guard(lock);
+        return stats.capacityBytes > 0;
+    }
+
+    // Snapshot of the counters
+    CacheStats statistics() const {
+        lock_guard<mutex> guard(lock);
+        return stats;
+    }
+};
+
+/*
+ * NamePool class
+ * Interned location names. The characters of every name live back to back
+ * in an arena of large blocks, and one open-addressing hash table (linear
+ * probing) maps names to location indices using string_view keys into the
+ * arena. Storing a name costs no per-name heap allocation and looking one up
+ * needs no temporary string.
+ */
+class NamePool {
+private:
+    vector<shared_ptr<char[]>> blocks; // Arena blocks; never moved, so views stay valid
+    size_t blockUsed = 0;              // Bytes used in the last block
+    size_t blockSize = 0;              // Capacity of the last block
+
+    vector<string_view> names;         // Name per index slot (empty when free)
+    vector<int> table;                 // Hash slots: location index, EMPTY or ERASED
+    size_t occupied = 0;               // Slots holding an index or ERASED
+
+    static constexpr int EMPTY = -1;
+    static constexpr int ERASED = -2;
+    static constexpr size_t BLOCK_BYTES = 64 * 1024;
+
+    // Copies a name into the arena and returns the stable view of the copy
+    string_view store(string_view name) {
+        if (name.size() > blockSize - blockUsed) {
+            reserveBytes(max(BLOCK_BYTES, name.size()));
+        }
+        char* dst = blocks.back().get() + blockUsed;
+        memcpy(dst, name.data(), name.size());
+        blockUsed += name.size();
+        return string_view(dst, name.size());
+    }
+
+    // Rebuilds the hash table with room for at least count names at <= 50% load
+    void rehash(size_t count) {
+        size_t capacity = 16;
+        while (capacity < count * 2) capacity *= 2;
+        table.assign(capacity, EMPTY);
+        occupied = 0;
+        for (size_t i = 0; i < names.size(); ++i) {
+            if (names[i].data()) insertSlot(names[i], i);
+        }
+    }
+
+    // Places an index into the first free slot of its probe sequence
+    void insertSlot(string_view name, int index) {
+        size_t mask = table.size() - 1;
+        size_t h = hash<string_view>()(name) & mask;
+        while (table[h] >= 0) h = (h + 1) & mask;
+        if (table[h] == EMPTY) occupied++;
+        table[h] = index;
+    }
+
+    // Finds the hash slot holding a name, or -1
+    int slotOf(string_view name) const {
+        if (table.empty()) return -1;
+        size_t mask = table.size() - 1;
+        for (size_t h = hash<string_view>()(name) & mask; table[h] != EMPTY; h = (h + 1) & mask) {
+            if (table[h] >= 0 && names[table[h]] == name) return h;
+        }
+        return -1;
+    }
+
+public:
+    NamePool() = default;
+    NamePool(NamePool&&) = default;
+    NamePool& operator=(NamePool&&) = default;
+
+    /*
+     * Copies the index without copying any characters: both pools share the
+     * arena blocks, whose written bytes never change. The copy opens a block
+     * of its own on its next insert, so neither pool ever writes where the
+     * other already has.
+     */
+    NamePool(const NamePool& other)
+        : blocks(other.blocks), names(other.names), table(other.table), occupied(other.occupied) {}
+
+    /*
+     * Looks up a name
+     * @param name: Location name
+     * @return: Index, or -1 if not interned
+     */
+    int find(string_view name) const {
+        int slot = slotOf(name);
+        return slot < 0 ? -1 : table[slot];
+    }
+
+    /*
+     * Interns a name that is not yet in the pool at an index slot
+     * @param index: Free slot, or slotCount() to append one
+     * @param name: Location name
+     */
+    void assign(int index, string_view name) {
+        if (index == (int)names.size()) names.emplace_back();
+        if ((occupied + 1) * 2 > table.size()) rehash(names.size());
+        // A non-null view marks the slot as used, even for an empty name
+        names[index] = name.empty() ? string_view("", 0) : store(name);
+        insertSlot(names[index], index);
+    }
+
+    /*
+     * Releases the name at an index slot (its arena bytes are reclaimed by
+     * the next compaction)
+     * @param index: Slot holding a name
+     */
+    void erase(int index) {
+        int slot = slotOf(names[index]);
+        if (slot >= 0) table[slot] = ERASED;
+        names[index] = string_view();
+    }
+
+    /*
+     * Name stored at an index slot (empty for free slots)
+     * @param index: Location index
+     */
+    string_view name(int index) const {
+        return names[index];
+    }
+
+    // Number of index slots, including free ones
+    int slotCount() const { return names.size(); }
+
+    /*
+     * Appends free slots until there are count slots in total
+     * @param count: New slot count (not smaller than slotCount())
+     */
+    void growSlots(int count) {
+        names.resize(count);
+    }
+
+    /*
+     * Pre-sizes the pool so adding names causes no rehash or new block
+     * @param count: Expected number of names in total
+     * @param bytes: Expected total bytes of names still to be added
+     */
+    void reserve(size_t count, size_t bytes = 0) {
+        names.reserve(count);
+        if (count * 2 > table.size()) rehash(count);
+        if (bytes > blockSize - blockUsed) reserveBytes(bytes);
+    }
+
+    // Starts a new arena block with room for at least bytes
+    void reserveBytes(size_t bytes) {
+        blocks.emplace_back(new char[bytes]);
+        blockUsed = 0;
+        blockSize = bytes;
+    }
+
+};
+
+/*
+ * TravelProfiles class
+ * Interned piecewise-linear travel-time profiles. A profile is a list of
+ * (time of day, travel time) breakpoints over a repeating PERIOD; travel
+ * time between breakpoints is interpolated, and the last breakpoint
+ * interpolates towards the first one of the next period. Identical profiles
+ * are stored once, and all breakpoints live in two flat arrays.
+ */
+class TravelProfiles {
+public:
+    static constexpr int PERIOD = 1440; // One day in minute costs
+
+    /*
+     * Checks that breakpoints describe a usable profile: non-empty, times
+     * strictly increasing within [0, PERIOD), travel times non-negative, and
+     * no segment dropping faster than time passes, so leaving later never
+     * means arriving earlier (the FIFO property time-dependent Dijkstra needs)
+     * @param points: (time of day, travel time) breakpoints
+     */
+    static bool valid(const vector<pair<int, int>>& points) {
+        if (points.empty()) return false;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (points[i].first < 0 || points[i].first >= PERIOD || points[i].second < 0) return false;
+            if (i > 0 && points[i].first <= points[i - 1].first) return false;
+        }
+        for (size_t i = 0; i < points.size(); ++i) {
+            const pair<int, int>& a = points[i];
+            const pair<int, int>& b = points[(i + 1) % points.size()];
+            long long span = (i + 1 < points.size()) ? b.first - a.first : b.first + PERIOD - a.first;
+            if ((long long)a.second - b.second > span) return false;
+        }
+        return true;
+    }
+
+    /*
+     * Stores a profile, reusing an identical one if it exists
+     * @param points: Breakpoints that pass valid()
+     * @return: Profile id
+     */
+    int intern(const vector<pair<int, int>>& points) {
+        uint64_t h = 1469598103934665603ULL; // FNV-1a over the breakpoints
+        for (const auto& p : points) {
+            h = (h ^ (uint32_t)p.first) * 1099511628211ULL;
+            h = (h ^ (uint32_t)p.second) * 1099511628211ULL;
+        }
+        vector<int>& candidates = byHash[h];
+        for (int id : candidates) {
+            if (same(id, points)) return id;
+        }
+        int id = start.size() - 1;
+        for (const auto& p : points) {
+            times.push_back(p.first);
+            values.push_back(p.second);
+        }
+        start.push_back(times.size());
+        candidates.push_back(id);
+        for (const auto& p : points) largest = max(largest, p.second);
+        return id;
+    }
+
+    /*
+     * Travel time of a profile for a given departure
+     * @param id: Profile id
+     * @param departure: Departure time (any non-negative time, taken modulo PERIOD)
+     */
+    int travelTime(int id, int departure) const {
+        int first = start[id], last = start[id + 1];
+        int t = departure % PERIOD;
+
+        // Segment [a, b) that contains t, wrapping around the period
+        int b = upper_bound(times.begin() + first, times.begin() + last, t) - times.begin();
+        int a = b - 1;
+        int ta, tb;
+        if (a < first) {
+            a = last - 1;
+            ta = times[a] - PERIOD;
+        } else {
+            ta = times[a];
+        }
+        if (b == last) {
+            b = first;
+            tb = times[b] + PERIOD;
+        } else {
+            tb = times[b];
+        }
+        if (tb == ta) return values[a]; // Single breakpoint: constant profile
+        return values[a] + (long long)(values[b] - values[a]) * (t - ta) / (tb - ta);
+    }
+
+    // Number of distinct profiles stored
+    int size() const { return start.size() - 1; }
+
+    // Largest travel time any profile can return (breakpoints bound the
+    // interpolated values)
+    int maxTravelTime() const { return largest; }
+
+    // Bytes held by the breakpoint arrays
+    size_t bytes() const { return (times.size() + values.size() + start.size()) * sizeof(int); }
+
+private:
+    vector<int> start = vector<int>(1, 0); // Breakpoints of profile p: [start[p], start[p + 1])
+    vector<int> times;                     // Time of day of every breakpoint
+    vector<int> values;                    // Travel time at every breakpoint
+    unordered_map<uint64_t, vector<int>> byHash; // Content hash -> profile ids
+    int largest = 0;                             // Largest breakpoint travel time
+
+    // Whether profile id has exactly these breakpoints
+    bool same(int id, const vector<pair<int, int>>& points) const {
+        if (start[id + 1] - start[id] != (int)points.size()) return false;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (times[start[id] + i] != points[i].first || values[start[id] + i] != points[i].second) return false;
+        }
+        return true;
+    }
+};
+
+/*
+ * SnapshotHeader struct
+ * Fixed-size header of a graph snapshot file. The file stores, in native
+ * byte order and each starting on an 8-byte boundary:
+ *   int32    offsets[n + 1]       CSR edge ranges
+ *   Index    targets[m]           CSR neighbors (CSRGraph::Index)
+ *   Weight   costs[m]             CSR edge costs (CSRGraph::Weight)
+ *   GeoPoint coordinates[n]
+ *   uint8    flags[n]             SNAPSHOT_LIVE | SNAPSHOT_HAS_COORDINATES
+ *   uint64   nameOffsets[n + 1]   String table ranges
+ *   char     names[nameBytes]     Location names, back to back
+ * so a loader can use pointers into the mapping as typed arrays.
+ */
+struct SnapshotHeader {
+    uint32_t magic;        // SNAPSHOT_FILE_MAGIC
+    uint32_t version;      // SNAPSHOT_FILE_VERSION
+    uint32_t vertexCount;  // Index slots n, including tombstones
+    uint32_t edgeCount;    // Directed CSR edges m
+    int32_t minCost;       // Smallest edge cost
+    int32_t maxCost;       // Largest edge cost
+    uint32_t edgeLayout;   // CSRGraph::layoutTag() of the writer
+    uint32_t reserved;     // Zero
+    uint64_t nameBytes;    // Size of the string table
+
+    static const uint32_t SNAPSHOT_FILE_MAGIC = 0x48504744;  // "DGPH"
+    static const uint32_t SNAPSHOT_FILE_VERSION = 2;
+    static const uint8_t SNAPSHOT_LIVE = 1;
+    static const uint8_t SNAPSHOT_HAS_COORDINATES = 2;
+
+    // Rounds a byte offset up to the next section boundary
+    static size_t align(size_t offset) { return (offset + 7) & ~(size_t)7; }
+
+    // Byte offsets of each section, and the total file size
+    size_t offsetsAt() const { return align(sizeof(SnapshotHeader)); }
+    size_t targetsAt() const { return align(offsetsAt() + (vertexCount + 1) * sizeof(int32_t)); }
+    size_t costsAt() const { return align(targetsAt() + (size_t)edgeCount * sizeof(CSRGraph::Index)); }
+    size_t coordinatesAt() const { return align(costsAt() + (size_t)edgeCount * sizeof(CSRGraph::Weight)); }
+    size_t flagsAt() const { return align(coordinatesAt() + (size_t)vertexCount * sizeof(GeoPoint)); }
+    size_t nameOffsetsAt() const { return align(flagsAt() + vertexCount); }
+    size_t namesAt() const { return align(nameOffsetsAt() + (vertexCount + 1) * sizeof(uint64_t)); }
+    size_t fileSize() const { return namesAt() + nameBytes; }
+};
+
+/*
+ * DeliveryPathOptimizer class
+ * Manages locations, routes, and path optimization algorithms
+ */
+class DeliveryPathOptimizer {
+private:
+    // Interned names: name -> index lookups and index -> name for display
+    // (empty for a tombstoned slot)
+    NamePool names;
+    
+    // Adjacency list representation of the graph
+    // Each entry is a vector of pairs: (neighbor_index, cost)
+    vector<vector<pair<int, int>>> adjList;
+    
+    // Total number of live (non-removed) locations in the system
+    int locationCount;
+
+    // Tombstone flag per index slot; removed slots keep their position
+    // so that every other location's index stays stable
+    vector<bool> removed;
+
+    // Tombstoned slots available for reuse by addLocation
+    vector<int> freeSlots;
+
+    // Optional position per index slot, used by A* heuristics
+    vector<GeoPoint> coordinates;
+    vector<bool> hasCoordinates;
+
+    // Priority queue backend for Dijkstra-based queries
+    HeapKind heapKind;
+
+    // Vertex numbering of the CSR snapshot
+    VertexOrder vertexOrder;
+
+    // Lower-bound estimate used by SearchMode::AStar
+    // (defaults to great-circle distance at 120 km/h with minute costs)
+    Heuristic heuristic;
+
+    // Frozen CSR snapshot used by the query path.
+    // Mutations drop it; the next query (or freeze()) republishes a new one.
+    mutable shared_ptr<const CSRGraph> snapshot;
+
+    // Serializes the lazy builds of snapshot and edgeProfiles, which const
+    // queries on several threads may start at once (both pointers are read
+    // with atomic_load outside it)
+    mutable mutex freezeLock;
+
+    // True after loadSnapshot(): adjList is empty and the snapshot is the
+    // only copy of the routes until the first mutation thaws it
+    bool adjListStale;
+
+    // ALT landmark tables for the current graph (null if not built/loaded)
+    shared_ptr<const LandmarkTable> landmarkTable;
+
+    // Contraction hierarchy for the current graph (null if not built)
+    shared_ptr<const ContractionHierarchy> hierarchy;
+
+    // Shortest-path tree kept up to date across route changes
+    struct TrackedSource {
+        ShortestPathTree tree;  // Distances and predecessors from tree.origin
+        bool stale;             // Needs a full recompute (after a structural change)
+    };
+
+    // Sources registered with trackSource()
+    vector<TrackedSource> trackedSources;
+
+    // Incremented by every mutation; stamps cached results
+    uint64_t version;
+
+    // Recently computed delivery plans (see setResultCacheLimit)
+    mutable ResultCache resultCache;
+
+    // Rush-hour travel-time profiles, and the profile of each profiled route
+    // keyed by routeKey(u, v) in both directions
+    TravelProfiles profiles;
+    unordered_map<uint64_t, int> routeProfiles;
+
+    // Profile of every snapshot edge (-1 for a static cost), built on demand
+    mutable shared_ptr<const vector<int>> edgeProfiles;
+
+    // Subtree membership marks for tree repairs (all zero between repairs)
+    vector<char> repairMarks;
+
+    // Route mutation queued by an open batch (see beginBatch())
+    enum class ChangeKind { Add, Remove, Update };
+    struct RouteChange {
+        int u, v;        // Endpoints (u <= v once sorted)
+        int sequence;    // Call order within the batch
+        ChangeKind kind;
+        int cost;        // New cost (unused for Remove)
+    };
+
+    // Whether route mutations are queued rather than applied
+    bool batching;
+
+    // Route mutations queued since beginBatch(), in call order
+    vector<RouteChange> pendingChanges;
+
+    // Whether each route touched by the queue exists once it is applied
+    unordered_map<uint64_t, bool> pendingRoutes;
+
+    /*
+     * Drops every structure derived from adjList after a mutation
+     */
+    void graphChanged() {
+        version++; // Cached results from before this point are stale
+        snapshot.reset();
+        edgeProfiles.reset();
+        landmarkTable.reset();
+        hierarchy.reset();
+    }
+
+    /*
+     * Drops the per-edge profile ids after a profile change. Static costs
+     * are unchanged, so the snapshot, landmarks and hierarchy stay valid.
+     */
+    void profilesChanged() {
+        version++; // Answers of optimizeDeliveryPlanAt() may differ from here on
+        edgeProfiles.reset();
+    }
+
+    /*
+     * Rebuilds the editable adjacency list from a loaded snapshot.
+     * Called by every mutator before it touches adjList.
+     */
+    void thaw() {
+        if (!adjListStale) return;
+        adjList = unpackRoutes(*snapshot);
+        adjListStale = false;
+    }
+
+    // Adjacency list (by location index) holding the routes of a snapshot
+    static vector<vector<pair<int, int>>> unpackRoutes(const CSRGraph& g) {
+        int n = g.vertexCount();
+        vector<vector<pair<int, int>>> routes(n);
+        for (int u = 0; u < n; ++u) {
+            vector<pair<int, int>>& edges = routes[g.locationOf(u)];
+            edges.reserve(g.offsets[u + 1] - g.offsets[u]);
+            for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+                edges.push_back(make_pair(g.locationOf(g.targets[e]), g.costs[e]));
+            }
+        }
+        return routes;
+    }
+
+    /*
+     * Effective cost of the route between two locations: the cheapest of any
+     * parallel routes, or numeric_limits<int>::max() if there is none
+     */
+    int routeCost(int u, int v) const {
+        int best = numeric_limits<int>::max();
+        for (const auto& p : adjList[u]) {
+            if (p.first == v) best = min(best, p.second);
+        }
+        return best;
+    }
+
+    /*
+     * Marks every tracked tree for a full recompute; used by mutations that
+     * renumber or remove locations rather than change a single route
+     */
+    void trackedTreesChanged() {
+        for (auto& t : trackedSources) t.stale = true;
+    }
+
+    // Queues a route mutation of an open batch
+    void queueChange(int u, int v, ChangeKind kind, int cost) {
+        RouteChange change = { u, v, (int)pendingChanges.size(), kind, cost };
+        pendingChanges.push_back(change);
+        if (kind != ChangeKind::Update) pendingRoutes[routeKey(min(u, v), max(u, v))] = kind == ChangeKind::Add;
+    }
+
+    /*
+     * Whether a route exists once the changes queued so far are applied
+     * @param u: One endpoint
+     * @param v: Other endpoint
+     */
+    bool routeExistsAfterQueue(int u, int v) {
+        auto it = pendingRoutes.find(routeKey(min(u, v), max(u, v)));
+        if (it != pendingRoutes.end()) return it->second;
+        thaw();
+        return routeCost(u, v) != numeric_limits<int>::max();
+    }
+
+    /*
+     * Applies the queued route mutations in one pass per touched adjacency
+     * list. Changes are sorted by route and folded, in call order, into one
+     * net change per route: whether its existing entries survive, the cost
+     * they end up with, and the costs of routes added after the last removal.
+     */
+    void applyPendingChanges() {
+        if (pendingChanges.empty()) return;
+        thaw();
+
+        for (auto& c : pendingChanges) {
+            if (c.u > c.v) swap(c.u, c.v);
+        }
+        sort(pendingChanges.begin(), pendingChanges.end(), [](const RouteChange& a, const RouteChange& b) {
+            if (a.u != b.u) return a.u < b.u;
+            if (a.v != b.v) return a.v < b.v;
+            return a.sequence < b.sequence;
+        });
+
+        // Fold each route's changes into one net change
+        struct NetChange {
+            int u, v;
+            bool keep = true;          // Existing entries survive
+            bool recost = false;       // Existing entries take `cost`
+            int cost = 0;
+            size_t addedBegin = 0;     // Range of added route costs in `added`
+            size_t addedEnd = 0;
+        };
+        vector<NetChange> net;
+        vector<int> added;
+        for (size_t i = 0; i < pendingChanges.size();) {
+            NetChange n;
+            n.u = pendingChanges[i].u;
+            n.v = pendingChanges[i].v;
+            n.addedBegin = added.size();
+            for (; i < pendingChanges.size() && pendingChanges[i].u == n.u && pendingChanges[i].v == n.v; ++i) {
+                const RouteChange& c = pendingChanges[i];
+                if (c.kind == ChangeKind::Add) {
+                    added.push_back(c.cost);
+                } else if (c.kind == ChangeKind::Remove) {
+                    n.keep = false;
+                    added.resize(n.addedBegin);
+                } else {
+                    // Like updateRouteCost: every route present now changes
+                    n.recost = true;
+                    n.cost = c.cost;
+                    fill(added.begin() + n.addedBegin, added.end(), c.cost);
+                }
+            }
+            n.addedEnd = added.size();
+            net.push_back(n);
+        }
+        vector<RouteChange>().swap(pendingChanges);
+        pendingRoutes.clear();
+
+        // One record per adjacency list a route lives in, grouped by list
+        vector<pair<int, int>> touches; // (list, net change)
+        touches.reserve(net.size() * 2);
+        for (int i = 0; i < (int)net.size(); ++i) {
+            touches.push_back(make_pair(net[i].u, i));
+            if (net[i].v != net[i].u) touches.push_back(make_pair(net[i].v, i));
+            if (!net[i].keep) {
+                routeProfiles.erase(routeKey(net[i].u, net[i].v));
+                routeProfiles.erase(routeKey(net[i].v, net[i].u));
+            }
+        }
+        sort(touches.begin(), touches.end());
+
+        vector<int> changeOf(adjList.size(), -1); // Net change per neighbor of the current list
+        for (size_t i = 0; i < touches.size();) {
+            int u = touches[i].first;
+            size_t first = i;
+            for (; i < touches.size() && touches[i].first == u; ++i) {
+                const NetChange& n = net[touches[i].second];
+                changeOf[n.u == u ? n.v : n.u] = touches[i].second;
+            }
+
+            // Single pass: drop or recost existing entries, then append
+            vector<pair<int, int>>& list = adjList[u];
+            size_t kept = 0;
+            for (size_t e = 0; e < list.size(); ++e) {
+                int c = changeOf[list[e].first];
+                if (c >= 0) {
+                    if (!net[c].keep) continue;
+                    if (net[c].recost) list[e].second = net[c].cost;
+                }
+                list[kept++] = list[e];
+            }
+            list.resize(kept);
+            for (size_t k = first; k < i; ++k) {
+                const NetChange& n = net[touches[k].second];
+                int other = (n.u == u) ? n.v : n.u;
+                int copies = (n.u == n.v) ? 2 : 1; // addRoute stores a self-loop twice
+                for (int copy = 0; copy < copies; ++copy) {
+                    for (size_t a = n.addedBegin; a < n.addedEnd; ++a) {
+                        list.push_back(make_pair(other, added[a]));
+                    }
+                }
+                changeOf[other] = -1;
+            }
+        }
+
+        graphChanged(); // Derived query structures no longer match adjList
+        trackedTreesChanged();
+    }
+
+    /*
+     * Recomputes a tracked tree from scratch on the current graph
+     * @param t: Tracked source to rebuild
+     */
+    void refreshTree(TrackedSource& t) {
+        int src = names.find(t.tree.origin);
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        fillTree(*graph, src, defaultWorkspace(), true, t.tree);
+        t.stale = false;
+    }
+
+    /*
+     * Brings every tracked tree in line with the graph after the effective
+     * cost of the u-v route changed (Ramalingam-Reps style dynamic SSSP).
+     * A cheaper route only re-labels vertices it actually improves; a dearer
+     * (or removed) route only matters if it is a tree edge, in which case just
+     * the subtree hanging below it is re-labelled.
+     * @param u: One endpoint
+     * @param v: Other endpoint
+     * @param oldCost: Previous effective cost (max int if there was no route)
+     * @param newCost: New effective cost (max int if the route is gone)
+     */
+    void repairTrackedTrees(int u, int v, int oldCost, int newCost) {
+        if (oldCost == newCost || u == v) return;
+        for (auto& t : trackedSources) {
+            if (t.stale) {
+                refreshTree(t);
+            } else if (newCost < oldCost) {
+                repairDecrease(t.tree, u, v, newCost);
+            } else {
+                repairIncrease(t.tree, u, v);
+            }
+        }
+    }
+
+    // Re-labels the vertices improved by a cheaper u-v route
+    void repairDecrease(ShortestPathTree& tree, int u, int v, int cost) {
+        const int INF = numeric_limits<int>::max();
+        vector<int>& dist = tree.distances;
+        vector<int>& pred = tree.predecessors;
+        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+        auto seed = [&](int a, int b) {
+            if (dist[a] != INF && dist[a] + cost < dist[b]) {
+                dist[b] = dist[a] + cost;
+                pred[b] = a;
+                pq.push(make_pair(dist[b], b));
+            }
+        };
+        seed(u, v);
+        seed(v, u);
+        propagate(tree, pq);
+    }
+
+    // Re-labels the subtree that hung below a u-v tree edge that got dearer
+    void repairIncrease(ShortestPathTree& tree, int u, int v) {
+        const int INF = numeric_limits<int>::max();
+        vector<int>& dist = tree.distances;
+        vector<int>& pred = tree.predecessors;
+        int child = pred[v] == u ? v : pred[u] == v ? u : -1;
+        if (child < 0) return; // Not a tree edge: no distance depends on it
+
+        // Collect the subtree below the edge through predecessor links
+        if (repairMarks.size() < dist.size()) repairMarks.resize(dist.size(), 0);
+        vector<int> subtree(1, child);
+        repairMarks[child] = 1;
+        for (size_t head = 0; head < subtree.size(); ++head) {
+            int x = subtree[head];
+            for (const auto& p : adjList[x]) {
+                if (pred[p.first] == x && !repairMarks[p.first]) {
+                    repairMarks[p.first] = 1;
+                    subtree.push_back(p.first);
+                }
+            }
+        }
+
+        // Forget the subtree's labels, then seed each vertex with its best
+        // route from outside the subtree (outside labels are still exact)
+        for (int x : subtree) {
+            dist[x] = INF;
+            pred[x] = -1;
+        }
+        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+        for (int x : subtree) {
+            for (const auto& p : adjList[x]) {
+                int y = p.first;
+                if (!repairMarks[y] && dist[y] != INF && dist[y] + p.second < dist[x]) {
+                    dist[x] = dist[y] + p.second;
+                    pred[x] = y;
+                }
+            }
+            if (dist[x] != INF) pq.push(make_pair(dist[x], x));
+        }
+        for (int x : subtree) repairMarks[x] = 0;
+        propagate(tree, pq);
+    }
+
+    // Dijkstra over adjList continuing from already-seeded labels
+    void propagate(ShortestPathTree& tree,
+                   priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>>& pq) {
+        vector<int>& dist = tree.distances;
+        vector<int>& pred = tree.predecessors;
+        while (!pq.empty()) {
+            int d = pq.top().first, x = pq.top().second;
+            pq.pop();
+            if (d > dist[x]) continue; // Outdated entry
+            for (const auto& p : adjList[x]) {
+                if (d + p.second < dist[p.first]) {
+                    dist[p.first] = d + p.second;
+                    pred[p.first] = x;
+                    pq.push(make_pair(dist[p.first], p.first));
+                }
+            }
+        }
+    }
+
+    /*
+     * Vertex numbering for the next CSR snapshot (empty for identity).
+     * Hilbert order needs coordinates and falls back to BFS without them.
+     */
+    vector<int> vertexSequence() const {
+        switch (vertexOrder) {
+            case VertexOrder::BFS:
+                return breadthFirstOrder(adjList, false);
+            case VertexOrder::ReverseCuthillMcKee:
+                return breadthFirstOrder(adjList, true);
+            case VertexOrder::Hilbert: {
+                vector<int> order = hilbertOrder(coordinates, hasCoordinates);
+                return order.empty() ? breadthFirstOrder(adjList, false) : order;
+            }
+            case VertexOrder::Insertion:
+            default:
+                return vector<int>();
+        }
+    }
+
+    /*
+     * Returns the current CSR snapshot, rebuilding it if a mutation
+     * has invalidated the previous one
+     */
+    shared_ptr<const CSRGraph> frozenGraph() const {
+        shared_ptr<const CSRGraph> graph = atomic_load(&snapshot);
+        if (graph) return graph;
+        lock_guard<mutex> guard(freezeLock);
+        graph = atomic_load(&snapshot); // Another reader may have built it meanwhile
+        if (!graph) {
+            graph = make_shared<const CSRGraph>(adjList, vertexSequence());
+            atomic_store(&snapshot, graph);
+        }
+        return graph;
+    }
+
+    // Key of the directed route u -> v in routeProfiles
+    static uint64_t routeKey(int u, int v) {
+        return ((uint64_t)(uint32_t)u << 32) | (uint32_t)v;
+    }
+
+    /*
+     * Returns the profile id of every edge of a snapshot, building the
+     * array if routes or profiles changed since the last call
+     * @param g: Current snapshot (from frozenGraph())
+     */
+    shared_ptr<const vector<int>> frozenProfiles(const CSRGraph& g) const {
+        shared_ptr<const vector<int>> built = atomic_load(&edgeProfiles);
+        if (built) return built;
+        lock_guard<mutex> guard(freezeLock);
+        built = atomic_load(&edgeProfiles);
+        if (!built) {
+            auto ids = make_shared<vector<int>>(g.edgeCount(), -1);
+            if (!routeProfiles.empty()) {
+                for (int u = 0; u < g.vertexCount(); ++u) {
+                    for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+                        auto it = routeProfiles.find(routeKey(g.locationOf(u), g.locationOf(g.targets[e])));
+                        if (it != routeProfiles.end()) (*ids)[e] = it->second;
+                    }
+                }
+            }
+            built = ids;
+            atomic_store(&edgeProfiles, built);
+        }
+        return built;
+    }
+
+    /*
+     * Time-dependent Dijkstra over travel time since departure. Arrival order
+     * is preserved by FIFO profiles, so settled labels are final.
+     * @param g: Graph snapshot to search
+     * @param edgeProfile: Profile id of every edge (-1 = static cost)
+     * @param src: Origin index
+     * @param departure: Departure time in [0, PERIOD)
+     * @param maxCost: Largest cost any edge can take, static or profiled
+     * @param space: Labels that receive the result
+     * @param pq: Empty queue backend
+     */
+    template <class Queue>
+    void timeDependentLoop(const CSRGraph& g, const vector<int>& edgeProfile, int src, int departure,
+                           int maxCost, SearchSpace& space, Queue& pq) const {
+        const int PERIOD = TravelProfiles::PERIOD;
+        space.reset(g.vertexCount());
+        pq.reset(g.vertexCount(), maxCost);
+        space.set(src, 0, -1);
+        pq.push(0, src);
+        uint64_t pushes = 1, stale = 0, relaxed = 0, settled = 0;
+        while (!pq.empty()) {
+            pair<int, int> top = pq.pop();
+            int d = top.first, u = top.second;
+            if (d > space.distance(u)) { // Outdated entry
+                stale++;
+                continue;
+            }
+            settled++;
+            int clock = (int)((departure + (long long)d) % PERIOD);
+            relaxed += g.offsets[u + 1] - g.offsets[u];
+            for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+                int cost = edgeProfile[e] < 0 ? (int)g.costs[e] : profiles.travelTime(edgeProfile[e], clock);
+                int v = g.targets[e];
+                if (space.distance(v) > d + cost) {
+                    space.set(v, d + cost, u);
+                    pq.push(d + cost, v);
+                    pushes++;
+                }
+            }
+        }
+        recordSearch(pushes, stale, relaxed, settled);
+    }
+
+    /*
+     * Converts a predecessor chain ending at dst into named stops
+     * @param g: Graph snapshot the labels were computed on
+     * @param labels: Search labels holding the predecessors (-1 at the origin)
+     * @param dst: Last vertex of the path
+     */
+    vector<string> reconstructStops(const CSRGraph& g, const SearchSpace& labels, int dst) const {
+        vector<string> stops;
+        for (int v = dst; v != -1; v = labels.predecessor(v)) {
+            stops.push_back(string(names.name(g.locationOf(v))));
+        }
+        reverse(stops.begin(), stops.end());
+        return stops;
+    }
+
+    /*
+     * Runs a full single-source Dijkstra and expands its sparse labels into
+     * dense per-location arrays
+     * @param g: Graph snapshot to search
+     * @param src: Origin location index
+     * @param ws: Workspace owned by the calling thread
+     * @param withPredecessors: Also fill tree.predecessors
+     * @param tree: Result to fill (origin and found are left untouched)
+     */
+    void fillTree(const CSRGraph& g, int src, QueryWorkspace& ws, bool withPredecessors,
+                  ShortestPathTree& tree) const {
+        runDijkstra(g, g.vertexOf(src), -1, heapKind, ws);
+        int n = g.vertexCount();
+        tree.distances.assign(n, numeric_limits<int>::max());
+        if (withPredecessors) tree.predecessors.assign(n, -1);
+        for (int v : ws.forward.touchedVertices()) {
+            int loc = g.locationOf(v);
+            tree.distances[loc] = ws.forward.distance(v);
+            if (withPredecessors) {
+                int pred = ws.forward.predecessor(v);
+                tree.predecessors[loc] = pred < 0 ? -1 : g.locationOf(pred);
+            }
+        }
+    }
+
+    /*
+     * Renumbers a per-vertex result array of a reordered snapshot so it is
+     * indexed by location, the way every public result is
+     * @param g: Graph snapshot the values were computed on
+     * @param values: Per-vertex values, replaced by per-location values
+     */
+    static void toLocationOrder(const CSRGraph& g, vector<int>& values) {
+        if (!g.reordered()) return;
+        vector<int> byLocation(values.size());
+        for (size_t v = 0; v < values.size(); ++v) byLocation[g.locationOf(v)] = values[v];
+        values.swap(byLocation);
+    }
+
+    /*
+     * Inserts a location into a free or new slot
+     * @param name: Name of the location to add
+     * @param position: Coordinates of the location (ignored if !known)
+     * @param known: Whether the location has coordinates
+     * @return: Status::AlreadyExists if the name is taken
+     */
+    Status insertLocation(string_view name, const GeoPoint& position, bool known) {
+        // Check if location already exists
+        if (names.find(name) >= 0) return Status::AlreadyExists;
+        placeLocation(name, position, known);
+        return Status::Ok;
+    }
+
+    /*
+     * Stores a location that is known not to exist yet
+     * @param name: Name of the location to add
+     * @param position: Coordinates of the location (ignored if !known)
+     * @param known: Whether the location has coordinates
+     * @return: Index of the new location
+     */
+    int placeLocation(string_view name, const GeoPoint& position, bool known) {
+        thaw();
+
+        // Reuse a tombstoned slot if one is free, otherwise append a new one
+        int idx;
+        if (!freeSlots.empty()) {
+            idx = freeSlots.back();
+            freeSlots.pop_back();
+            removed[idx] = false;
+        } else {
+            idx = names.slotCount();
+            adjList.emplace_back(); // Add empty adjacency list for new location
+            removed.push_back(false);
+            coordinates.emplace_back();
+            hasCoordinates.push_back(false);
+        }
+        coordinates[idx] = position;
+        hasCoordinates[idx] = known;
+        names.assign(idx, name); // Intern the name at its slot
+        for (auto& t : trackedSources) {
+            if (t.stale || idx < (int)t.tree.distances.size()) continue;
+            t.tree.distances.push_back(numeric_limits<int>::max()); // New isolated slot
+            t.tree.predecessors.push_back(-1);
+        }
+        locationCount++;
+        graphChanged(); // Derived query structures no longer match adjList
+        return idx;
+    }
+
+public:
+    // Constructor - initializes with 0 locations
+    DeliveryPathOptimizer()
+        : locationCount(0), heapKind(HeapKind::Auto), vertexOrder(VertexOrder::Insertion),
+          heuristic(greatCircleHeuristic(2.0)), adjListStale(false), version(0),
+          resultCache(DEFAULT_CACHE_BYTES), batching(false) {}
+
+    // Default memory cap of the delivery plan cache
+    static const size_t DEFAULT_CACHE_BYTES = 64 << 20;
+
+    // Default per-driver time budget of planDeliveryTour()
+    static const int DEFAULT_TOUR_BUDGET_MS = 50;
+
+    /*
+     * Caps the memory of the delivery plan cache; evicts least recently used
+     * plans to fit. Each cached plan costs about 8 bytes per location slot.
+     * @param bytes: Memory cap (0 disables caching)
+     */
+    void setResultCacheLimit(size_t bytes) {
+        resultCache.setCapacity(bytes);
+    }
+
+    /*
+     * Hit, miss and memory counters of the delivery plan cache
+     */
+    CacheStats resultCacheStats() const {
+        return resultCache.statistics();
+    }
+
+    /*
+     * Search counters and query latencies of every optimizer in the process
+     * (all zero when built with DELPATHOPT_METRICS=0)
+     */
+    QueryMetrics queryMetrics() const {
+        return MetricsRegistry::instance().collect();
+    }
+
+    /*
+     * Renders the instrumentation counters, the query latency summaries and
+     * the cache counters in Prometheus text exposition format. Each query
+     * type also reports its slowest query with the origin it started from,
+     * to tie slow queries to parts of the network.
+     * @return: Metrics page, one sample per line
+     */
+    string metricsText() const {
+        string out;
+        auto sample = [&out](const string& name, const string& labels, const string& value) {
+            out += name;
+            if (!labels.empty()) out += "{" + labels + "}";
+            out += " " + value + "\n";
+        };
+        auto family = [&out](const char* name, const char* type, const char* help) {
+            out += string("# HELP ") + name + " " + help + "\n";
+            out += string("# TYPE ") + name + " " + type + "\n";
+        };
+
+#if DELPATHOPT_METRICS
+        auto seconds = [](uint64_t nanos) {
+            char number[32];
+            snprintf(number, sizeof(number), "%.9g", nanos * 1e-9);
+            return string(number);
+        };
+        QueryMetrics m = queryMetrics();
+        family("delpathopt_heap_pushes_total", "counter", "Priority queue pushes made by Dijkstra searches.");
+        sample("delpathopt_heap_pushes_total", "", to_string(m.heapPushes));
+        family("delpathopt_stale_pops_total", "counter", "Queue entries skipped because a shorter label was found later.");
+        sample("delpathopt_stale_pops_total", "", to_string(m.stalePops));
+        family("delpathopt_edges_relaxed_total", "counter", "Edges examined from settled vertices.");
+        sample("delpathopt_edges_relaxed_total", "", to_string(m.edgesRelaxed));
+        family("delpathopt_vertices_settled_total", "counter", "Vertices settled by Dijkstra searches.");
+        sample("delpathopt_vertices_settled_total", "", to_string(m.verticesSettled));
+
+        static const char* const QUERY_LABELS[] = {
+            "delivery_plan", "delivery_plan_at", "shortest_path", "service_area", "distance_matrix", "delivery_tour",
+            "parallel_delivery_plan", "simulation", "batch_optimize"
+        };
+        static_assert(sizeof(QUERY_LABELS) / sizeof(QUERY_LABELS[0]) == (size_t)QueryKind::Count,
+                      "one label per QueryKind");
+        static const char* const QUANTILES[] = { "0.5", "0.9", "0.99", "0.999" };
+        family("delpathopt_query_duration_seconds", "summary", "Query latency, from a log-linear histogram (6.25% resolution).");
+        for (int k = 0; k < (int)QueryKind::Count; ++k) {
+            const LatencyStats& stats = m.latency[k];
+            string query = string("query=\"") + QUERY_LABELS[k] + "\"";
+            for (const char* q : QUANTILES) {
+                sample("delpathopt_query_duration_seconds", query + ",quantile=\"" + q + "\"",
+                       seconds(stats.percentile(atof(q))));
+            }
+            sample("delpathopt_query_duration_seconds_sum", query, seconds(stats.sumNanos));
+            sample("delpathopt_query_duration_seconds_count", query, to_string(stats.total));
+        }
+        family("delpathopt_query_slowest_seconds", "gauge", "Slowest query of each type and the location it started from.");
+        for (int k = 0; k < (int)QueryKind::Count; ++k) {
+            const LatencyStats& stats = m.latency[k];
+            if (stats.total == 0) continue;
+            string labels = string("query=\"") + QUERY_LABELS[k] + "\"";
+            if (stats.slowestOrigin >= 0 && stats.slowestOrigin < indexCount() && isLive(stats.slowestOrigin)) {
+                labels += ",origin=\"";
+                for (char c : locationName(stats.slowestOrigin)) {
+                    if (c == '\\' || c == '"') labels += '\\';
+                    if (c == '\n') labels += "\\n";
+                    else labels += c;
+                }
+                labels += "\"";
+            }
+            sample("delpathopt_query_slowest_seconds", labels, seconds(stats.maxNanos));
+        }
+#endif
+
+        CacheStats cache = resultCacheStats();
+        family("delpathopt_cache_hits_total", "counter", "Delivery plans answered from the result cache.");
+        sample("delpathopt_cache_hits_total", "", to_string(cache.hits));
+        family("delpathopt_cache_misses_total", "counter", "Delivery plans that had to run a search.");
+        sample("delpathopt_cache_misses_total", "", to_string(cache.misses));
+        family("delpathopt_cache_evictions_total", "counter", "Result cache entries dropped to stay under the memory cap.");
+        sample("delpathopt_cache_evictions_total", "", to_string(cache.evictions));
+        family("delpathopt_cache_bytes", "gauge", "Memory held by the result cache.");
+        sample("delpathopt_cache_bytes", "", to_string(cache.bytes));
+        return out;
+    }
+
+    /*
+     * Current graph version; changes whenever a location, route or route
+     * profile does
+     */
+    uint64_t graphVersion() const {
+        return version;
+    }
+
+    /*
+     * Adds a new location to the delivery network
+     * @param name: Name of the location to add
+     * @return: Status::AlreadyExists if the name is taken
+     */
+    Status addLocation(string_view name) {
+        return insertLocation(name, GeoPoint(), false);
+    }
+
+    /*
+     * Adds a new location with known coordinates to the delivery network
+     * @param name: Name of the location to add
+     * @param lat: Latitude in decimal degrees
+     * @param lon: Longitude in decimal degrees
+     * @return: Status::AlreadyExists if the name is taken
+     */
+    Status addLocation(string_view name, double lat, double lon) {
+        GeoPoint position;
+        position.lat = lat;
+        position.lon = lon;
+        return insertLocation(name, position, true);
+    }
+
+    /*
+     * Selects the priority queue used by Dijkstra-based queries.
+     * HeapKind::Auto picks Dial's buckets for costs up to DIAL_MAX_COST and
+     * the indexed 4-ary heap above that; HeapKind::Binary is the original heap.
+     * @param kind: Queue backend
+     */
+    void setHeapKind(HeapKind kind) {
+        heapKind = kind;
+    }
+
+    /*
+     * Replaces the lower-bound estimate used by SearchMode::AStar
+     * @param h: Admissible heuristic over location coordinates
+     */
+    void setHeuristic(Heuristic h) {
+        heuristic = move(h);
+    }
+
+    /*
+     * Chooses how the CSR snapshot numbers its vertices. Only memory layout
+     * changes: every result is still indexed by location. Drops the current
+     * snapshot and its preprocessing, which are tied to the old numbering.
+     * @param order: Vertex numbering to use from the next freeze on
+     */
+    void setVertexOrder(VertexOrder order) {
+        if (order == vertexOrder) return;
+        thaw();
+        vertexOrder = order;
+        graphChanged();
+    }
+
+    /*
+     * Removes a location from the delivery network.
+     * The slot is tombstoned rather than erased, so only the location's own
+     * routes are touched and no other index changes; compact() reclaims
+     * tombstoned slots in one batch.
+     * @param name: Name of the location to remove
+     * @return: Status::NotFound if the location does not exist,
+     *          Status::InvalidArgument while a batch is open
+     */
+    Status removeLocation(string_view name) {
+        // Check if location exists
+        int idx = names.find(name);
+        if (idx < 0) return Status::NotFound;
+        if (batching) return Status::InvalidArgument; // Queued changes may reference this slot
+        thaw();
+        untrackSource(name);
+        names.erase(idx);
+
+        // Remove the reverse entry of every route touching this location
+        for (const auto& route : adjList[idx]) {
+            if (!routeProfiles.empty()) {
+                routeProfiles.erase(routeKey(idx, route.first));
+                routeProfiles.erase(routeKey(route.first, idx));
+            }
+            if (route.first == idx) continue; // Self-loop, dropped below
+            auto& neighbors = adjList[route.first];
+            neighbors.erase(remove_if(neighbors.begin(), neighbors.end(),
+                [idx](const pair<int, int>& p) { return p.first == idx; }), neighbors.end());
+        }
+
+        // Release the location's own routes and tombstone the slot
+        vector<pair<int, int>>().swap(adjList[idx]);
+        removed[idx] = true;
+        freeSlots.push_back(idx);
+        
+        locationCount--; // Decrement total location count
+        trackedTreesChanged();
+        graphChanged(); // Derived query structures no longer match adjList
+        return Status::Ok;
+    }
+
+    /*
+     * Reclaims all tombstoned slots in a single O(V + E) pass.
+     * Live locations are renumbered densely in their current order, so
+     * indices held from before the call are invalidated.
+     * @return: Number of slots reclaimed (0 if there was nothing to compact,
+     *          -1 while a batch is open)
+     */
+    int compact() {
+        if (batching) return -1; // Queued changes use the old numbering
+        int slots = names.slotCount();
+        int reclaimed = slots - locationCount;
+        if (reclaimed == 0) return 0;
+        thaw();
+
+        // Map each live slot to its new dense index
+        vector<int> newIndex(slots, -1);
+        int next = 0;
+        for (int i = 0; i < slots; ++i) {
+            if (!removed[i]) newIndex[i] = next++;
+        }
+
+        // Move live slots down and rewrite route targets; names are
+        // re-interned into a fresh pool, which also drops removed names' bytes
+        size_t nameBytes = 0;
+        for (int i = 0; i < slots; ++i) nameBytes += names.name(i).size();
+        NamePool packed;
+        packed.reserve(locationCount, nameBytes);
+        for (int i = 0; i < slots; ++i) {
+            if (removed[i]) continue;
+            int j = newIndex[i];
+            for (auto& p : adjList[i]) {
+                p.first = newIndex[p.first];
+            }
+            packed.assign(j, names.name(i));
+            if (j != i) {
+                adjList[j] = move(adjList[i]);
+                coordinates[j] = coordinates[i];
+                hasCoordinates[j] = hasCoordinates[i];
+            }
+        }
+        adjList.resize(locationCount);
+        names = move(packed);
+        if (!routeProfiles.empty()) {
+            unordered_map<uint64_t, int> renumbered;
+            for (const auto& entry : routeProfiles) {
+                int u = newIndex[entry.first >> 32], v = newIndex[(uint32_t)entry.first];
+                renumbered[routeKey(u, v)] = entry.second;
+            }
+            routeProfiles.swap(renumbered);
+        }
+        trackedTreesChanged();
+        coordinates.resize(locationCount);
+        hasCoordinates.resize(locationCount);
+        removed.assign(locationCount, false);
+        freeSlots.clear();
+
+        graphChanged(); // Derived query structures no longer match adjList
+        return reclaimed;
+    }
+
+    /*
+     * Opens a batch: until commitBatch(), addRoute, removeRoute and
+     * updateRouteCost validate their arguments and queue the change instead
+     * of applying it, so queries keep seeing the graph as it was. Calls that
+     * renumber or replace locations (removeLocation, compact, importGraph,
+     * loadSnapshot) are rejected until the batch is committed, so nothing
+     * queued is ever applied early, and so are route profile changes, which
+     * would otherwise be checked against routes the batch has not applied.
+     * @return: Status::NothingToDo if a batch is already open
+     */
+    Status beginBatch() {
+        if (batching) return Status::NothingToDo;
+        batching = true;
+        return Status::Ok;
+    }
+
+    /*
+     * Applies every change queued since beginBatch() in one pass per touched
+     * adjacency list, with the same result as making the calls one by one,
+     * and rebuilds the snapshot once on the next query.
+     * @return: Status::NothingToDo if no batch is open
+     */
+    Status commitBatch() {
+        if (!batching) return Status::NothingToDo;
+        batching = false;
+        applyPendingChanges();
+        return Status::Ok;
+    }
+
+    // Number of changes queued by the open batch
+    size_t pendingChangeCount() const { return pendingChanges.size(); }
+
+    /*
+     * Adds a bidirectional route between two locations
+     * @param from: Starting location
+     * @param to: Destination location
+     * @param cost: Time or distance cost between locations
+     * @return: Status::NotFound if either location does not exist,
+     *          Status::InvalidArgument if the cost does not fit CSRGraph::Weight
+     */
+    Status addRoute(string_view from, string_view to, int cost) {
+        // Get indices for both locations
+        int u = names.find(from), v = names.find(to);
+        if (u < 0 || v < 0) return Status::NotFound;
+        if (!CSRGraph::fitsCost(cost)) return Status::InvalidArgument;
+        if (batching) {
+            queueChange(u, v, ChangeKind::Add, cost);
+            return Status::Ok;
+        }
+        thaw();
+        
+        // Add to both adjacency lists (undirected graph)
+        int oldCost = routeCost(u, v);
+        adjList[u].push_back(make_pair(v, cost));
+        adjList[v].push_back(make_pair(u, cost));
+        graphChanged(); // Derived query structures no longer match adjList
+        repairTrackedTrees(u, v, oldCost, min(oldCost, cost));
+        return Status::Ok;
+    }
+
+    /*
+     * Changes the cost of the route between two locations in place (of every
+     * parallel route, if there are several) and repairs tracked trees
+     * incrementally instead of recomputing them
+     * @param from: One endpoint
+     * @param to: Other endpoint
+     * @param newCost: New time or distance cost
+     * @return: Status::NotFound if either location or the route does not exist,
+     *          Status::InvalidArgument if the cost does not fit CSRGraph::Weight
+     */
+    Status updateRouteCost(string_view from, string_view to, int newCost) {
+        int u = names.find(from), v = names.find(to);
+        if (u < 0 || v < 0) return Status::NotFound;
+        if (!CSRGraph::fitsCost(newCost)) return Status::InvalidArgument;
+        if (batching) {
+            // Same answer as the direct call once earlier changes are applied
+            if (!routeExistsAfterQueue(u, v)) return Status::NotFound;
+            queueChange(u, v, ChangeKind::Update, newCost);
+            return Status::Ok;
+        }
+        thaw();
+        int oldCost = routeCost(u, v);
+        if (oldCost == numeric_limits<int>::max()) return Status::NotFound;
+
+        for (auto& p : adjList[u]) {
+            if (p.first == v) p.second = newCost;
+        }
+        for (auto& p : adjList[v]) {
+            if (p.first == u) p.second = newCost;
+        }
+        graphChanged(); // Derived query structures no longer match adjList
+        repairTrackedTrees(u, v, oldCost, newCost);
+        return Status::Ok;
+    }
+
+    /*
+     * Removes a route between two locations
+     * @param from: Starting location
+     * @param to: Destination location
+     * @return: Status::NotFound if either location does not exist
+     */
+    Status removeRoute(string_view from, string_view to) {
+        // Get indices for both locations
+        int u = names.find(from), v = names.find(to);
+        if (u < 0 || v < 0) return Status::NotFound;
+        if (batching) {
+            queueChange(u, v, ChangeKind::Remove, 0);
+            return Status::Ok;
+        }
+        thaw();
+
+        // Remove from first location's adjacency list
+        int oldCost = routeCost(u, v);
+        auto& listU = adjList[u];
+        listU.erase(remove_if(listU.begin(), listU.end(),
+            [v](const pair<int, int>& p) { return p.first == v; }), listU.end());
+
+        // Remove from second location's adjacency list
+        auto& listV = adjList[v];
+        listV.erase(remove_if(listV.begin(), listV.end(),
+            [u](const pair<int, int>& p) { return p.first == u; }), listV.end());
+        routeProfiles.erase(routeKey(u, v));
+        routeProfiles.erase(routeKey(v, u));
+        graphChanged(); // Derived query structures no longer match adjList
+        repairTrackedTrees(u, v, oldCost, numeric_limits<int>::max());
+        return Status::Ok;
+    }
+
+    /*
+     * Gives the route between two locations a time-of-day travel-time
+     * profile, used by optimizeDeliveryPlanAt() in place of its static cost
+     * (for every parallel route between the pair). Static queries keep using
+     * the cost given to addRoute. Routes with identical profiles share one copy.
+     * @param from: One endpoint
+     * @param to: Other endpoint
+     * @param points: (minute of day, travel time) breakpoints, see TravelProfiles
+     * @return: Status::NotFound if either location or the route does not exist,
+     *          Status::InvalidArgument if the breakpoints fail TravelProfiles::valid()
+     *          or a batch is open
+     */
+    Status setRouteProfile(string_view from, string_view to, const vector<pair<int, int>>& points) {
+        if (batching) return Status::InvalidArgument; // Queued changes may add or remove the route
+        int u = names.find(from), v = names.find(to);
+        if (u < 0 || v < 0) return Status::NotFound;
+        thaw();
+        if (routeCost(u, v) == numeric_limits<int>::max()) return Status::NotFound;
+        if (!TravelProfiles::valid(points)) return Status::InvalidArgument;
+
+        int id = profiles.intern(points);
+        routeProfiles[routeKey(u, v)] = id;
+        routeProfiles[routeKey(v, u)] = id;
+        profilesChanged();
+        return Status::Ok;
+    }
+
+    /*
+     * Returns the route between two locations to its static cost
+     * @param from: One endpoint
+     * @param to: Other endpoint
+     * @return: Status::NotFound if either location does not exist,
+     *          Status::NothingToDo if the route has no profile,
+     *          Status::InvalidArgument while a batch is open
+     */
+    Status clearRouteProfile(string_view from, string_view to) {
+        if (batching) return Status::InvalidArgument;
+        int u = names.find(from), v = names.find(to);
+        if (u < 0 || v < 0) return Status::NotFound;
+        if (routeProfiles.erase(routeKey(u, v)) == 0) return Status::NothingToDo;
+        routeProfiles.erase(routeKey(v, u));
+        profilesChanged();
+        return Status::Ok;
+    }
+
+    /*
+     * Number of distinct travel-time profiles stored
+     */
+    int profileCount() const {
+        return profiles.size();
+    }
+
+    /*
+     * Bulk-loads locations and routes from text files without per-edge I/O.
+     * The locations file has one "name" or "name,lat,lon" line per location;
+     * the routes file has one "from,to,cost" line per bidirectional route,
+     * and endpoints that are not yet known are added as locations. Blank
+     * lines, '#' comments and lines that don't parse (such as a header row)
+     * are skipped. Both files are memory-mapped and tokenized in place;
+     * adjacency lists are reserved to their final size before routes are
+     * inserted.
+     * @param locationsPath: Locations file ("" to take names from routes only)
+     * @param routesPath: Routes file ("" to load locations only)
+     * @return: Counts and timing; status == Status::IoError (with nothing
+     *          loaded) if a file could not be mapped, Status::InvalidArgument
+     *          (with nothing loaded) while a batch is open
+     */
+    ImportReport importGraph(const string& locationsPath, const string& routesPath) {
+        auto started = chrono::steady_clock::now();
+        ImportReport report;
+        if (batching) {
+            report.status = Status::InvalidArgument;
+            return report;
+        }
+        MappedFile locationsFile, routesFile;
+        if ((!locationsPath.empty() && !locationsFile.open(locationsPath, true)) ||
+            (!routesPath.empty() && !routesFile.open(routesPath, true))) {
+            report.status = Status::IoError;
+            return report;
+        }
+        thaw();
+
+        // Line counts bound the number of new names, so hash and slot
+        // storage grow once instead of rehashing during the load
+        size_t locationLines = countLines(locationsFile.data(), locationsFile.size());
+        size_t routeLines = countLines(routesFile.data(), routesFile.size());
+        size_t expected = names.slotCount() + locationLines;
+        names.reserve(expected, locationsFile.size());
+        adjList.reserve(expected);
+
+        // Names are looked up as views into the mapping, so known names cost
+        // no allocation
+        auto intern = [&](const char* begin, const char* end) {
+            string_view key(begin, end - begin);
+            int idx = names.find(key);
+            if (idx >= 0) return idx;
+            report.locationsAdded++;
+            return placeLocation(key, GeoPoint(), false);
+        };
+
+        forEachLine(locationsFile.data(), locationsFile.size(), [&](const char* b, const char* e) {
+            if (b == e || *b == '#') { report.linesSkipped++; return; }
+            const char* comma = static_cast<const char*>(memchr(b, ',', e - b));
+            GeoPoint position;
+            bool known = comma != nullptr;
+            if (known) {
+                const char* lat = comma + 1;
+                const char* sep = static_cast<const char*>(memchr(lat, ',', e - lat));
+                if (!sep || !parseField(lat, sep, position.lat) ||
+                    !parseField(sep + 1, e, position.lon)) {
+                    report.linesSkipped++;
+                    return;
+                }
+            }
+            string_view key(b, (comma ? comma : e) - b);
+            if (names.find(key) >= 0) { report.linesSkipped++; return; }
+            placeLocation(key, position, known);
+            report.locationsAdded++;
+        });
+
+        // First pass: resolve endpoints and count degrees
+        vector<int> from, to, cost;
+        from.reserve(routeLines);
+        to.reserve(routeLines);
+        cost.reserve(routeLines);
+        forEachLine(routesFile.data(), routesFile.size(), [&](const char* b, const char* e) {
+            if (b == e || *b == '#') { report.linesSkipped++; return; }
+            const char* c1 = static_cast<const char*>(memchr(b, ',', e - b));
+            const char* c2 = c1 ? static_cast<const char*>(memchr(c1 + 1, ',', e - c1 - 1)) : nullptr;
+            int w;
+            if (!c2 || !parseField(c2 + 1, e, w) || !CSRGraph::fitsCost(w)) {
+                report.linesSkipped++;
+                return;
+            }
+            from.push_back(intern(b, c1));
+            to.push_back(intern(c1 + 1, c2));
+            cost.push_back(w);
+        });
+        vector<int> degree(adjList.size(), 0);
+        for (size_t i = 0; i < from.size(); ++i) {
+            degree[from[i]]++;
+            degree[to[i]]++;
+        }
+        for (size_t u = 0; u < adjList.size(); ++u) {
+            if (degree[u]) adjList[u].reserve(adjList[u].size() + degree[u]);
+        }
+
+        // Second pass: insert both directions, as addRoute does
+        for (size_t i = 0; i < from.size(); ++i) {
+            adjList[from[i]].push_back(make_pair(to[i], cost[i]));
+            adjList[to[i]].push_back(make_pair(from[i], cost[i]));
+        }
+        report.routesAdded = from.size();
+        trackedTreesChanged();
+        graphChanged(); // Derived query structures no longer match adjList
+
+        report.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        return report;
+    }
+
+    /*
+     * Compiles the current adjacency list into an immutable CSR snapshot.
+     * Queries freeze lazily on demand; calling this up front moves the
+     * build cost out of the first query after a batch of mutations. Const
+     * queries may run on several threads at once (each with its own
+     * workspace), and the first of them builds the snapshot for all, but
+     * no mutation may run while they do.
+     */
+    void freeze() const {
+        frozenGraph();
+    }
+
+    /*
+     * Returns an immutable copy of the current state that any number of
+     * threads can query at once while this object keeps changing. Every
+     * lazily built structure is built first, so queries on the copy never
+     * write shared state (its result cache has its own lock). The copy
+     * shares the CSR snapshot, name arena and preprocessing instead of
+     * duplicating them, leaving O(V) work beyond the freeze.
+     */
+    shared_ptr<const DeliveryPathOptimizer> readOnlyCopy() const {
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        shared_ptr<const vector<int>> ids = frozenProfiles(*graph);
+
+        auto copy = make_shared<DeliveryPathOptimizer>();
+        copy->names = NamePool(names);
+        copy->locationCount = locationCount;
+        copy->removed = removed;
+        copy->freeSlots = freeSlots;
+        copy->coordinates = coordinates;
+        copy->hasCoordinates = hasCoordinates;
+        copy->heapKind = heapKind;
+        copy->vertexOrder = vertexOrder;
+        copy->heuristic = heuristic;
+        copy->snapshot = graph;
+        copy->adjListStale = true; // Routes are only needed by mutators
+        copy->landmarkTable = landmarkTable;
+        copy->hierarchy = hierarchy;
+        copy->trackedSources = trackedSources;
+        copy->version = version;
+        copy->resultCache.setCapacity(resultCache.statistics().capacityBytes);
+        copy->profiles = profiles;
+        copy->edgeProfiles = ids; // routeProfiles is only read to rebuild this
+        return copy;
+    }
+
+    /*
+     * Checks the arrays of a mapped snapshot in one linear pass, so that a
+     * corrupt or hostile file is rejected instead of indexing out of bounds
+     * later: CSR offsets must run from 0 to edgeCount without decreasing,
+     * every target must be a vertex, every cost must lie in the header's
+     * range, and name offsets must not decrease or pass the string table.
+     * @param header: Header already checked against the file size
+     * @param base: Start of the mapped file
+     */
+    static bool snapshotArraysValid(const SnapshotHeader& header, const char* base) {
+        size_t n = header.vertexCount, m = header.edgeCount;
+        const int32_t* offsets = (const int32_t*)(base + header.offsetsAt());
+        if (offsets[0] != 0 || (size_t)offsets[n] != m) return false;
+        for (size_t v = 0; v < n; ++v) {
+            if (offsets[v + 1] < offsets[v]) return false;
+        }
+
+        const CSRGraph::Index* targets = (const CSRGraph::Index*)(base + header.targetsAt());
+        const CSRGraph::Weight* costs = (const CSRGraph::Weight*)(base + header.costsAt());
+        for (size_t e = 0; e < m; ++e) {
+            if ((long long)targets[e] < 0 || (unsigned long long)targets[e] >= n) return false;
+            if ((long long)costs[e] < header.minCost || (long long)costs[e] > header.maxCost) return false;
+        }
+
+        const uint64_t* nameOffsets = (const uint64_t*)(base + header.nameOffsetsAt());
+        if (nameOffsets[n] > header.nameBytes) return false;
+        for (size_t v = 0; v < n; ++v) {
+            if (nameOffsets[v + 1] < nameOffsets[v]) return false;
+        }
+        return true;
+    }
+
+    /*
+     * Writes the graph as a binary snapshot (see SnapshotHeader) that
+     * loadSnapshot() can map without parsing
+     * @param path: Output file path
+     * @return: Status::IoError if the file could not be written
+     */
+    Status saveSnapshot(const string& path) const {
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        // Files are laid out by location index; the numbering is rebuilt on use
+        if (graph->reordered()) {
+            graph = make_shared<const CSRGraph>(adjListStale ? unpackRoutes(*graph) : adjList);
+        }
+        const CSRGraph& g = *graph;
+        int n = g.vertexCount();
+
+        SnapshotHeader header = SnapshotHeader();
+        header.magic = SnapshotHeader::SNAPSHOT_FILE_MAGIC;
+        header.version = SnapshotHeader::SNAPSHOT_FILE_VERSION;
+        header.vertexCount = n;
+        header.edgeCount = g.edgeCount();
+        header.minCost = g.minCost;
+        header.maxCost = g.maxCost;
+        header.edgeLayout = CSRGraph::layoutTag();
+
+        vector<uint8_t> flags(n);
+        vector<uint64_t> nameOffsets(n + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            flags[i] = (removed[i] ? 0 : SnapshotHeader::SNAPSHOT_LIVE) |
+                       (hasCoordinates[i] ? SnapshotHeader::SNAPSHOT_HAS_COORDINATES : 0);
+            nameOffsets[i + 1] = nameOffsets[i] + names.name(i).size();
+        }
+        header.nameBytes = nameOffsets[n];
+
+        ofstream out(path, ios::binary);
+        if (!out) return Status::IoError;
+        size_t written = 0;
+        auto section = [&](size_t at, const void* data, size_t bytes) {
+            static const char zeros[8] = {};
+            out.write(zeros, at - written); // Pad up to the section boundary
+            out.write((const char*)data, bytes);
+            written = at + bytes;
+        };
+        section(0, &header, sizeof(header));
+        section(header.offsetsAt(), g.offsets.data(), g.offsets.size() * sizeof(int));
+        section(header.targetsAt(), g.targets.data(), g.targets.size() * sizeof(CSRGraph::Index));
+        section(header.costsAt(), g.costs.data(), g.costs.size() * sizeof(CSRGraph::Weight));
+        section(header.coordinatesAt(), coordinates.data(), n * sizeof(GeoPoint));
+        section(header.flagsAt(), flags.data(), n);
+        section(header.nameOffsetsAt(), nameOffsets.data(), nameOffsets.size() * sizeof(uint64_t));
+        section(header.namesAt(), nullptr, 0);
+        for (int i = 0; i < n; ++i) out.write(names.name(i).data(), names.name(i).size());
+        return out ? Status::Ok : Status::IoError;
+    }
+
+    /*
+     * Replaces the whole graph with a snapshot written by saveSnapshot().
+     * The file is memory-mapped and the query snapshot points straight at
+     * its CSR arrays, so queries can start without rebuilding anything
+     * edge-sized; the editable adjacency list is only rebuilt on the first
+     * mutation. Processes mapping the same file share its page cache.
+     * Existing landmark tables survive if they match the loaded graph.
+     * @param path: Input file path
+     * @return: Status::IoError if the file is unreadable, not a snapshot
+     *          of this format version, or names two locations alike,
+     *          Status::InvalidArgument while a batch is open
+     */
+    Status loadSnapshot(const string& path) {
+        if (batching) return Status::InvalidArgument;
+        auto file = make_shared<MappedFile>();
+        if (!file->open(path)) return Status::IoError;
+        SnapshotHeader header;
+        if (file->size() < sizeof(header)) return Status::IoError;
+        memcpy(&header, file->data(), sizeof(header));
+        if (header.magic != SnapshotHeader::SNAPSHOT_FILE_MAGIC ||
+            header.version != SnapshotHeader::SNAPSHOT_FILE_VERSION ||
+            header.edgeLayout != CSRGraph::layoutTag() ||
+            header.vertexCount > (uint32_t)numeric_limits<int>::max() ||
+            header.edgeCount > (uint32_t)numeric_limits<int>::max() ||
+            file->size() != header.fileSize()) {
+            return Status::IoError;
+        }
+
+        const char* base = file->data();
+        int n = header.vertexCount;
+        if (!snapshotArraysValid(header, base)) return Status::IoError;
+        auto graph = make_shared<const CSRGraph>(file,
+            (const int*)(base + header.offsetsAt()),
+            (const CSRGraph::Index*)(base + header.targetsAt()),
+            (const CSRGraph::Weight*)(base + header.costsAt()), n, (int)header.edgeCount,
+            header.minCost, header.maxCost);
+
+        // Per-location tables stay small next to the edges, so copy them
+        const GeoPoint* coords = (const GeoPoint*)(base + header.coordinatesAt());
+        const uint8_t* flags = (const uint8_t*)(base + header.flagsAt());
+        const uint64_t* nameOffsets = (const uint64_t*)(base + header.nameOffsetsAt());
+        const char* nameTable = base + header.namesAt();
+
+        // Names go into a fresh pool first, so a file that names two
+        // locations alike is rejected before anything is replaced
+        NamePool loadedNames;
+        loadedNames.reserve(n, header.nameBytes);
+        loadedNames.growSlots(n);
+        for (int i = 0; i < n; ++i) {
+            if (!(flags[i] & SnapshotHeader::SNAPSHOT_LIVE)) continue;
+            string_view name(nameTable + nameOffsets[i], nameOffsets[i + 1] - nameOffsets[i]);
+            if (loadedNames.find(name) >= 0) return Status::IoError;
+            loadedNames.assign(i, name);
+        }
+
+        shared_ptr<const LandmarkTable> landmarks = landmarkTable;
+        graphChanged();
+        adjList.clear();
+        profiles = TravelProfiles();
+        routeProfiles.clear();
+        names = move(loadedNames);
+        coordinates.assign(coords, coords + n);
+        removed.assign(n, false);
+        hasCoordinates.assign(n, false);
+        freeSlots.clear();
+        locationCount = 0;
+        for (int i = 0; i < n; ++i) {
+            hasCoordinates[i] = flags[i] & SnapshotHeader::SNAPSHOT_HAS_COORDINATES;
+            if (!(flags[i] & SnapshotHeader::SNAPSHOT_LIVE)) {
+                removed[i] = true;
+                freeSlots.push_back(i);
+                continue;
+            }
+            locationCount++;
+        }
+
+        snapshot = graph;
+        adjListStale = true;
+        trackedSources.clear(); // Tracked names may not exist in the new graph
+        if (landmarks && landmarks->vertexCount == n &&
+            landmarks->fingerprint == LandmarkTable::fingerprintOf(*graph)) {
+            landmarkTable = landmarks;
+        }
+        return Status::Ok;
+    }
+
+    /*
+     * Preprocesses ALT landmark tables for SearchMode::ALT
+     * @param k: Number of landmarks (more gives tighter bounds, more memory)
+     * @return: Status::InvalidArgument if k is not positive
+     */
+    Status buildLandmarks(int k) {
+        if (k <= 0) return Status::InvalidArgument;
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        vector<bool> live(removed.size());
+        for (size_t i = 0; i < removed.size(); ++i) live[graph->vertexOf(i)] = !removed[i];
+        landmarkTable = make_shared<const LandmarkTable>(LandmarkTable::build(*graph, live, k));
+        return Status::Ok;
+    }
+
+    /*
+     * Preprocesses a contraction hierarchy for SearchMode::ContractionHierarchy.
+     * Worth it when the graph changes rarely: any mutation discards it.
+     * @return: Number of shortcut edges added
+     */
+    int buildContractionHierarchy() {
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        hierarchy = make_shared<const ContractionHierarchy>(*graph);
+        return hierarchy->shortcutCount();
+    }
+
+    /*
+     * Saves the current landmark tables so later runs can skip preprocessing
+     * @param path: Output file path
+     * @return: Status::NotFound if no landmarks are built, Status::IoError
+     *          if the file could not be written
+     */
+    Status saveLandmarks(const string& path) const {
+        if (!landmarkTable) return Status::NotFound;
+        return landmarkTable->save(path) ? Status::Ok : Status::IoError;
+    }
+
+    /*
+     * Loads landmark tables, accepting them only if they were built for
+     * exactly the current graph
+     * @param path: Input file path
+     * @return: Status::IoError if the file is unreadable, Status::StaleData
+     *          if it was built for a different graph version
+     */
+    Status loadLandmarks(const string& path) {
+        LandmarkTable table;
+        if (!LandmarkTable::load(path, table)) return Status::IoError;
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        if (table.vertexCount != graph->vertexCount() ||
+            table.fingerprint != LandmarkTable::fingerprintOf(*graph)) {
+            return Status::StaleData;
+        }
+        landmarkTable = make_shared<const LandmarkTable>(move(table));
+        return Status::Ok;
+    }
+
+    /*
+     * Number of landmarks currently built or loaded (0 if none)
+     */
+    int landmarkCount() const {
+        return landmarkTable ? landmarkTable->landmarkCount() : 0;
+    }
+
+    /*
+     * Looks up the index of a location
+     * @param name: Location name
+     * @return: Index, or -1 if not found
+     */
+    int locationIndex(string_view name) const {
+        return names.find(name);
+    }
+
+    /*
+     * Returns the name stored at a location index (empty for tombstones)
+     * @param index: Location index
+     */
+    string_view locationName(int index) const {
+        return names.name(index);
+    }
+
+    /*
+     * Checks whether an index slot holds a location (false for tombstones)
+     * @param index: Location index
+     */
+    bool isLive(int index) const {
+        return !removed[index];
+    }
+
+    /*
+     * Number of live locations (excludes tombstoned slots)
+     */
+    int liveLocationCount() const {
+        return locationCount;
+    }
+
+    /*
+     * Number of location index slots, including tombstones; the size of
+     * every per-location result array
+     */
+    int indexCount() const {
+        return names.slotCount();
+    }
+
+    /*
+     * Computes shortest-path trees from many origins in parallel.
+     * All workers share one read-only snapshot and each owns a workspace,
+     * so nothing is locked while the queries run.
+     * @param origins: Origin location names
+     * @param threads: Worker threads (0 = hardware concurrency)
+     * @param withPredecessors: Also return the predecessor arrays
+     * @return: One tree per origin, in input order
+     */
+    vector<ShortestPathTree> batchOptimize(const vector<string>& origins, int threads = 0,
+                                           bool withPredecessors = false) const {
+        QueryTimer timer(QueryKind::BatchOptimize, -1);
+
+        // Publish the snapshot before fanning out so workers never rebuild it
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        const CSRGraph& g = *graph;
+
+        vector<ShortestPathTree> results(origins.size());
+        if (origins.empty()) return results;
+        if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+        vector<QueryWorkspace> workspaces(min<size_t>(threads, origins.size()));
+
+        parallelFor(origins.size(), workspaces.size(), [&](int worker, int i) {
+            ShortestPathTree& tree = results[i];
+            tree.origin = origins[i];
+            int src = names.find(origins[i]);
+            if (src < 0) return;
+            tree.found = true;
+
+            fillTree(g, src, workspaces[worker], withPredecessors, tree);
+        });
+        return results;
+    }
+
+    /*
+     * Computes the travel cost between every source and every target.
+     * With a contraction hierarchy built, this runs the bucket-based
+     * many-to-many algorithm: one upward search per target fills buckets,
+     * then one upward search per source scans them. Otherwise each row is a
+     * Dijkstra that stops once every target is settled. Rows (and target
+     * searches) are spread over worker threads; unknown names yield
+     * unreachable rows or columns.
+     * @param sources: Row location names
+     * @param targets: Column location names
+     * @param threads: Worker threads (0 = hardware concurrency)
+     */
+    DistanceMatrix distanceMatrix(const vector<string>& sources, const vector<string>& targets,
+                                  int threads = 0) const {
+        QueryTimer timer(QueryKind::DistanceMatrix, -1);
+        const int INF = numeric_limits<int>::max();
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        const CSRGraph& g = *graph;
+        shared_ptr<const ContractionHierarchy> ch = hierarchy;
 
-public:
-    // Constructor - initializes with 0 locations
-    DeliveryPathOptimizer() : locationCount(0) {}
+        DistanceMatrix matrix;
+        matrix.rows = sources.size();
+        matrix.cols = targets.size();
+        matrix.data.assign((size_t)matrix.rows * matrix.cols, INF);
+        if (matrix.rows == 0 || matrix.cols == 0) return matrix;
+
+        vector<int> rowIndex(matrix.rows), colIndex(matrix.cols);
+        auto vertexNamed = [&](const string& name) {
+            int loc = locationIndex(name);
+            return loc < 0 ? -1 : g.vertexOf(loc);
+        };
+        for (int i = 0; i < matrix.rows; ++i) rowIndex[i] = vertexNamed(sources[i]);
+        for (int j = 0; j < matrix.cols; ++j) colIndex[j] = vertexNamed(targets[j]);
+
+        if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+        vector<QueryWorkspace> workspaces(min(threads, max(matrix.rows, matrix.cols)));
+        int workers = workspaces.size();
+        int n = g.vertexCount();
+
+        if (ch) {
+            // Backward phase: every vertex in a target's upward space gets a
+            // bucket entry (column, distance), collected per worker
+            struct BucketEntry { int vertex; int col; int dist; };
+            struct SpaceRange { int worker; size_t begin; size_t end; };
+            vector<vector<BucketEntry>> collected(workers);
+            vector<SpaceRange> spaceOf(matrix.cols); // Entries of each target's upward space
+            parallelFor(matrix.cols, workers, [&](int worker, int j) {
+                if (colIndex[j] < 0) return;
+                QueryWorkspace& ws = workspaces[worker];
+                ch->upwardSearch(colIndex[j], ws.forward, ws.binary);
+                spaceOf[j].worker = worker;
+                spaceOf[j].begin = collected[worker].size();
+                for (int v : ws.forward.touchedVertices()) {
+                    BucketEntry entry = { v, j, ws.forward.distance(v) };
+                    collected[worker].push_back(entry);
+                }
+                spaceOf[j].end = collected[worker].size();
+            });
+
+            // Pack the buckets into CSR form keyed by vertex
+            vector<int> bucketStart(n + 1, 0);
+            for (const auto& list : collected) {
+                for (const auto& entry : list) bucketStart[entry.vertex + 1]++;
+            }
+            for (int v = 0; v < n; ++v) bucketStart[v + 1] += bucketStart[v];
+            vector<int> bucketCol(bucketStart[n]), bucketDist(bucketStart[n]); // Split for vector scans
+            vector<int> fill(bucketStart.begin(), bucketStart.end() - 1);
+            for (const auto& list : collected) {
+                for (const auto& entry : list) {
+                    bucketCol[fill[entry.vertex]] = entry.col;
+                    bucketDist[fill[entry.vertex]++] = entry.dist;
+                }
+            }
+
+            // Forward phase: each source scans the buckets of its upward space.
+            // Upward searches are the same in both directions (routes are
+            // symmetric), so a square matrix over one stop list reuses the
+            // target searches instead of running them again.
+            bool sameStops = (sources == targets);
+            if (!sameStops) vector<vector<BucketEntry>>().swap(collected);
+            SimdLevel simd = activeSimdLevel();
+            auto scan = [&](int* row, int u, int du) {
+                int b = bucketStart[u];
+                lowerRowEntries(simd, row, &bucketCol[b], &bucketDist[b], bucketStart[u + 1] - b, du);
+            };
+            parallelFor(matrix.rows, workers, [&](int worker, int i) {
+                if (rowIndex[i] < 0) return;
+                int* row = &matrix.data[(size_t)i * matrix.cols];
+                if (sameStops) {
+                    const vector<BucketEntry>& list = collected[spaceOf[i].worker];
+                    for (size_t k = spaceOf[i].begin; k < spaceOf[i].end; ++k) scan(row, list[k].vertex, list[k].dist);
+                    return;
+                }
+                QueryWorkspace& ws = workspaces[worker];
+                ch->upwardSearch(rowIndex[i], ws.forward, ws.binary);
+                for (int u : ws.forward.touchedVertices()) scan(row, u, ws.forward.distance(u));
+            });
+            return matrix;
+        }
+
+        // No hierarchy: one early-terminating Dijkstra per row
+        vector<char> isTarget(n, 0);
+        int distinctTargets = 0;
+        for (int t : colIndex) {
+            if (t >= 0 && !isTarget[t]) {
+                isTarget[t] = 1;
+                distinctTargets++;
+            }
+        }
+        parallelFor(matrix.rows, workers, [&](int worker, int i) {
+            if (rowIndex[i] < 0 || distinctTargets == 0) return;
+            QueryWorkspace& ws = workspaces[worker];
+            int remaining = distinctTargets;
+            runDijkstraUntil(g, rowIndex[i], heapKind, ws, [&](int u, int) {
+                return isTarget[u] && --remaining == 0;
+            });
+            int* row = &matrix.data[(size_t)i * matrix.cols];
+            for (int j = 0; j < matrix.cols; ++j) {
+                if (colIndex[j] >= 0) row[j] = ws.forward.distance(colIndex[j]);
+            }
+        });
+        return matrix;
+    }
 
     /*
-     * Adds a new location to the delivery network
-     * @param name: Name of the location to add
+     * Orders one driver's stops into a delivery sequence. The stop-to-stop
+     * costs come from distanceMatrix() (fast with a contraction hierarchy
+     * built), then orderTourStops() improves a nearest-neighbor tour in
+     * whatever is left of the time budget.
+     * @param origin: Driver's starting location
+     * @param stops: Locations to deliver to, in any order
+     * @param roundTrip: Whether the driver returns to the origin afterwards
+     * @param budgetMs: Time budget for the whole call, in milliseconds
+     * @param threads: Worker threads for the matrix (0 = hardware concurrency)
+     * @return: Stops in delivery order with their ETAs; Status::NotFound if
+     *          the origin is unknown
      */
-    void addLocation(const string& name) {
-        // Check if location already exists
-        if (locationToIndex.count(name)) {
-            cout << "Location already exists.\n";
-            return;
+    DeliveryTour planDeliveryTour(string_view origin, const vector<string>& stops, bool roundTrip = false,
+                                  int budgetMs = DEFAULT_TOUR_BUDGET_MS, int threads = 0) const {
+        auto started = chrono::steady_clock::now();
+        DeliveryTour tour;
+        int originIndex = names.find(origin);
+        if (originIndex < 0) {
+            tour.status = Status::NotFound;
+            return tour;
         }
-        
-        // Add to both mappings
-        locationToIndex[name] = locationCount++; // Assign and increment index
-        indexToLocation.push_back(name); // Add to name list
-        adjList.emplace_back(); // Add empty adjacency list for new location
-        
-        cout << "Location '" << name << "' added.\n";
+        QueryTimer timer(QueryKind::DeliveryTour, originIndex);
+
+        vector<string> points(1, string(origin));
+        for (const string& stop : stops) {
+            if (names.find(stop) < 0) tour.skipped.push_back(stop);
+            else points.push_back(stop);
+        }
+        DistanceMatrix matrix = distanceMatrix(points, points, threads);
+
+        // Tour nodes: 0 = origin, 1..k = reachable stops, k + 1 = end (the
+        // origin again for a round trip, otherwise free to reach from anywhere)
+        vector<int> pointOf(1, 0);
+        for (int i = 1; i < matrix.rows; ++i) {
+            if (matrix.at(0, i) == numeric_limits<int>::max()) tour.skipped.push_back(points[i]);
+            else pointOf.push_back(i);
+        }
+        int size = pointOf.size() + 1;
+        vector<int> cost((size_t)size * size, 0);
+        for (int a = 0; a + 1 < size; ++a) {
+            for (int b = 0; b + 1 < size; ++b) {
+                cost[(size_t)a * size + b] = matrix.at(pointOf[a], pointOf[b]);
+            }
+            if (roundTrip) {
+                cost[(size_t)a * size + size - 1] = matrix.at(pointOf[a], 0);
+                cost[(size_t)(size - 1) * size + a] = matrix.at(0, pointOf[a]);
+            }
+        }
+
+        double spent = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        vector<int> order = orderTourStops(cost, size, max(0.0, budgetMs / 1000.0 - spent), tour.moves);
+        for (int x = 1; x < size; ++x) {
+            tour.eta += cost[(size_t)order[x - 1] * size + order[x]];
+            if (x + 1 < size) {
+                tour.stops.push_back(points[pointOf[order[x]]]);
+                tour.arrivals.push_back(tour.eta);
+            }
+        }
+        tour.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        return tour;
     }
 
     /*
-     * Removes a location from the delivery network
-     * @param name: Name of the location to remove
+     * Registers a location whose shortest-path tree is kept up to date by
+     * route changes, so optimizeDeliveryPlan() from it needs no search.
+     * Route cost changes, additions and removals repair the tree in time
+     * proportional to the affected vertices; removing or renumbering
+     * locations schedules a full recompute.
+     * @param name: Origin location (e.g. a depot)
+     * @return: Status::NotFound if it does not exist, Status::AlreadyExists
+     *          if it is already tracked
      */
-    void removeLocation(const string& name) {
-        // Check if location exists
-        if (!locationToIndex.count(name)) {
-            cout << "Location not found.\n";
-            return;
+    Status trackSource(string_view name) {
+        if (names.find(name) < 0) return Status::NotFound;
+        for (const auto& t : trackedSources) {
+            if (t.tree.origin == name) return Status::AlreadyExists;
         }
+        TrackedSource t;
+        t.tree.origin = string(name);
+        t.tree.found = true;
+        refreshTree(t);
+        trackedSources.push_back(move(t));
+        return Status::Ok;
+    }
 
-        // Get the index of the location to remove
-        int idx = locationToIndex[name];
-        
-        // Remove from adjacency list
-        adjList.erase(adjList.begin() + idx);
-        
-        // Remove from name list
-        indexToLocation.erase(indexToLocation.begin() + idx);
+    /*
+     * Stops maintaining a location's tree
+     * @param name: Tracked origin location
+     * @return: Status::NotFound if it was not tracked
+     */
+    Status untrackSource(string_view name) {
+        for (size_t i = 0; i < trackedSources.size(); ++i) {
+            if (trackedSources[i].tree.origin != name) continue;
+            trackedSources.erase(trackedSources.begin() + i);
+            return Status::Ok;
+        }
+        return Status::NotFound;
+    }
 
-        // Remove all routes to/from this location and adjust indices
-        for (auto& neighbors : adjList) {
-            // Remove any routes to the deleted location
-            neighbors.erase(remove_if(neighbors.begin(), neighbors.end(),
-                [idx](const pair<int, int>& p) { return p.first == idx; }), neighbors.end());
+    /*
+     * Returns the maintained tree of a tracked source (with predecessors),
+     * recomputing it first if a structural change made it stale
+     * @param name: Tracked origin location
+     * @return: The tree, or null if the location is not tracked
+     */
+    const ShortestPathTree* trackedTree(string_view name) {
+        for (auto& t : trackedSources) {
+            if (t.tree.origin != name) continue;
+            if (t.stale) refreshTree(t);
+            return &t.tree;
+        }
+        return nullptr;
+    }
+
+    /*
+     * Calculates optimal delivery paths from a starting location
+     * using Dijkstra's algorithm
+     * @param start: Starting location for path calculation
+     * @return: Distance to every location index, or found == false if the
+     *          starting location does not exist
+     */
+    ShortestPathTree optimizeDeliveryPlan(string_view start) const {
+        return optimizeDeliveryPlan(start, defaultWorkspace());
+    }
+
+    /*
+     * Calculates optimal delivery paths from a starting location
+     * using Dijkstra's algorithm, reusing the caller's workspace. Threads
+     * may call this at once with their own workspaces (see freeze()).
+     * @param start: Starting location for path calculation
+     * @param ws: Workspace owned by the calling thread
+     * @return: Distance to every location index, or found == false if the
+     *          starting location does not exist
+     */
+    ShortestPathTree optimizeDeliveryPlan(string_view start, QueryWorkspace& ws) const {
+        ShortestPathTree plan;
+        plan.origin = string(start);
+
+        // Check if starting location exists
+        int src = names.find(start);
+        if (src < 0) return plan;
+        plan.found = true;
+        QueryTimer timer(QueryKind::DeliveryPlan, src);
+
+        // A tracked source's maintained tree already holds the answer
+        for (const auto& t : trackedSources) {
+            if (t.stale || t.tree.origin != start) continue;
+            plan.distances = t.tree.distances;
+            return plan;
+        }
 
-            // Adjust indices of locations after the removed one
-            for (auto& p : neighbors) {
-                if (p.first > idx) p.first--;
+        // Hot origins are answered from the cache while the graph is unchanged
+        bool caching = resultCache.enabled();
+        if (caching) {
+            shared_ptr<const ShortestPathTree> cached = resultCache.find(src, version);
+            if (cached) {
+                plan.distances = cached->distances;
+                return plan;
             }
         }
 
-        // Rebuild the locationToIndex mapping
-        locationToIndex.clear();
-        for (int i = 0; i < indexToLocation.size(); ++i) {
-            locationToIndex[indexToLocation[i]] = i;
+        // Run against the frozen CSR snapshot
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        if (!caching) {
+            fillTree(*graph, src, ws, false, plan);
+            return plan;
         }
-        
-        locationCount--; // Decrement total location count
-        cout << "Location '" << name << "' removed.\n";
+        auto tree = make_shared<ShortestPathTree>();
+        tree->origin = plan.origin;
+        tree->found = true;
+        fillTree(*graph, src, ws, true, *tree);
+        plan.distances = tree->distances;
+        resultCache.insert(src, version, move(tree));
+        return plan;
     }
 
     /*
-     * Adds a bidirectional route between two locations
+     * Finds every location within a travel-cost limit of a starting location
+     * with a bounded Dijkstra that stops at the first label past the limit.
+     * Only the settled set is returned, so the cost follows the size of the
+     * area rather than of the network.
+     * @param start: Starting location (e.g. a depot)
+     * @param limit: Largest distance to include
+     * @return: Reached locations nearest first, or found == false if the
+     *          starting location does not exist
+     */
+    ServiceArea serviceArea(string_view start, int limit) const {
+        return serviceArea(start, limit, defaultWorkspace());
+    }
+
+    /*
+     * Bounded search reusing the caller's workspace; safe on several
+     * threads at once like optimizeDeliveryPlan()
+     * @param start: Starting location (e.g. a depot)
+     * @param limit: Largest distance to include
+     * @param ws: Workspace owned by the calling thread
+     * @return: Reached locations nearest first, or found == false if the
+     *          starting location does not exist
+     */
+    ServiceArea serviceArea(string_view start, int limit, QueryWorkspace& ws) const {
+        ServiceArea area;
+        area.origin = string(start);
+        area.limit = limit;
+        int src = names.find(start);
+        if (src < 0) return area;
+        area.found = true;
+        QueryTimer timer(QueryKind::ServiceArea, src);
+        if (limit < 0) return area;
+
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        const CSRGraph& g = *graph;
+        if (g.minCost < 0) {
+            // Negative costs can lower settled labels, so search everything
+            runDijkstra(g, g.vertexOf(src), -1, heapKind, ws);
+            for (int v : ws.forward.touchedVertices()) {
+                int d = ws.forward.distance(v);
+                if (d <= limit) area.reached.push_back(make_pair(g.locationOf(v), d));
+            }
+            sort(area.reached.begin(), area.reached.end(),
+                 [](const pair<int, int>& x, const pair<int, int>& y) { return x.second < y.second; });
+            return area;
+        }
+
+        // Vertices settle in distance order, so the first one past the
+        // limit ends the search
+        runDijkstraUntil(g, g.vertexOf(src), heapKind, ws, [&](int u, int d) {
+            if (d > limit) return true;
+            area.reached.push_back(make_pair(g.locationOf(u), d));
+            return false;
+        });
+        return area;
+    }
+
+    /*
+     * Calculates delivery travel times for a departure time with
+     * time-dependent Dijkstra: a profiled route costs its profile's travel
+     * time at the moment it is entered, other routes their static cost.
+     * Profiles are FIFO, so the labels are still exact.
+     * @param start: Starting location for path calculation
+     * @param departure: Departure time in minutes after midnight
+     * @return: Travel time to every location index, or found == false if the
+     *          starting location does not exist
+     */
+    ShortestPathTree optimizeDeliveryPlanAt(string_view start, int departure) const {
+        return optimizeDeliveryPlanAt(start, departure, defaultWorkspace());
+    }
+
+    /*
+     * Time-dependent delivery plan reusing the caller's workspace
+     * @param start: Starting location for path calculation
+     * @param departure: Departure time in minutes after midnight
+     * @param ws: Workspace owned by the calling thread
+     * @return: Travel time to every location index, or found == false if the
+     *          starting location does not exist
+     */
+    ShortestPathTree optimizeDeliveryPlanAt(string_view start, int departure, QueryWorkspace& ws) const {
+        ShortestPathTree plan;
+        plan.origin = string(start);
+        int src = names.find(start);
+        if (src < 0) return plan;
+        plan.found = true;
+        QueryTimer timer(QueryKind::DeliveryPlanAt, src);
+
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        shared_ptr<const vector<int>> ids = frozenProfiles(*graph);
+        const CSRGraph& g = *graph;
+        const vector<int>& edgeProfile = *ids;
+        const int PERIOD = TravelProfiles::PERIOD;
+        departure = (departure % PERIOD + PERIOD) % PERIOD;
+
+        // Profiles can exceed the static cost range the backend was picked for
+        int maxCost = max((int)g.maxCost, profiles.maxTravelTime());
+        HeapKind kind = resolveHeapKind(heapKind, g);
+        if (kind == HeapKind::Dial && maxCost > DIAL_MAX_COST) kind = HeapKind::QuaternaryIndexed;
+        int origin = g.vertexOf(src);
+        switch (kind) {
+            case HeapKind::Dial:
+                timeDependentLoop(g, edgeProfile, origin, departure, maxCost, ws.forward, ws.dial);
+                break;
+            case HeapKind::Radix:
+                timeDependentLoop(g, edgeProfile, origin, departure, maxCost, ws.forward, ws.radix);
+                break;
+            case HeapKind::QuaternaryIndexed:
+                timeDependentLoop(g, edgeProfile, origin, departure, maxCost, ws.forward, ws.quaternary);
+                break;
+            case HeapKind::Binary:
+            default:
+                timeDependentLoop(g, edgeProfile, origin, departure, maxCost, ws.forward, ws.binary);
+                break;
+        }
+
+        plan.distances.assign(g.vertexCount(), numeric_limits<int>::max());
+        for (int v : ws.forward.touchedVertices()) plan.distances[g.locationOf(v)] = ws.forward.distance(v);
+        return plan;
+    }
+
+    /*
+     * Calculates the same delivery plan as optimizeDeliveryPlan() with
+     * parallel delta-stepping, for network-wide queries on large graphs.
+     * Falls back to sequential Dijkstra if any route cost is negative.
+     * @param start: Starting location for path calculation
+     * @param threads: Worker threads (0 = hardware concurrency)
+     * @param delta: Bucket width (0 = largest cost divided by average degree)
+     * @return: Distance to every location index, or found == false if the
+     *          starting location does not exist
+     */
+    ShortestPathTree parallelDeliveryPlan(string_view start, int threads = 0, int delta = 0) const {
+        ShortestPathTree plan;
+        plan.origin = string(start);
+        int src = names.find(start);
+        if (src < 0) return plan;
+        plan.found = true;
+        QueryTimer timer(QueryKind::ParallelDeliveryPlan, src);
+
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        const CSRGraph& g = *graph;
+        if (g.minCost < 0) {
+            fillTree(g, src, defaultWorkspace(), false, plan);
+            return plan;
+        }
+        if (delta <= 0) {
+            double degree = max(1.0, (double)g.edgeCount() / max(1, g.vertexCount()));
+            delta = max(1, (int)(g.maxCost / degree));
+        }
+        plan.distances = deltaSteppingDistances(g, g.vertexOf(src), delta, threads);
+        toLocationOrder(g, plan.distances);
+        return plan;
+    }
+
+    /*
+     * Simulates delivery route using Breadth-First Search (BFS)
+     * @param start: Starting location for simulation
+     * @return: Visit order and hop levels, or found == false if the starting
+     *          location does not exist
+     */
+    RouteSimulation simulateDelivery(string_view start) const {
+        return simulateDelivery(start, defaultWorkspace());
+    }
+
+    /*
+     * Simulates delivery route with a chosen BFS strategy. Both modes give
+     * identical levels; only BfsMode::Sequential fixes the order inside a level.
+     * @param start: Starting location for simulation
+     * @param mode: BFS strategy
+     * @param threads: Worker threads for BfsMode::DirectionOptimizing
+     *                 (0 = hardware concurrency)
+     * @return: Visit order and hop levels, or found == false if the starting
+     *          location does not exist
+     */
+    RouteSimulation simulateDelivery(string_view start, BfsMode mode, int threads = 0) const {
+        if (mode == BfsMode::Sequential) return simulateDelivery(start, defaultWorkspace());
+        RouteSimulation sim;
+        sim.origin = string(start);
+        int src = names.find(start);
+        if (src < 0) return sim;
+        sim.found = true;
+        QueryTimer timer(QueryKind::Simulation, src);
+
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        const CSRGraph& g = *graph;
+        directionOptimizingBfs(g, g.vertexOf(src), threads, sim.levels, sim.visitOrder);
+        toLocationOrder(g, sim.levels);
+        for (int& v : sim.visitOrder) v = g.locationOf(v);
+        return sim;
+    }
+
+    /*
+     * Simulates delivery route using Breadth-First Search (BFS),
+     * reusing the caller's workspace
+     * @param start: Starting location for simulation
+     * @param ws: Workspace owned by the calling thread
+     * @return: Visit order and hop levels, or found == false if the starting
+     *          location does not exist
+     */
+    RouteSimulation simulateDelivery(string_view start, QueryWorkspace& ws) const {
+        RouteSimulation sim;
+        sim.origin = string(start);
+
+        // Check if starting location exists
+        int src = names.find(start);
+        if (src < 0) return sim;
+        sim.found = true;
+        QueryTimer timer(QueryKind::Simulation, src);
+
+        // Run against the frozen CSR snapshot
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        const CSRGraph& g = *graph;
+
+        // BFS initialization: stamped labels act as visited markers and
+        // the result vector doubles as the queue
+        SearchSpace& visited = ws.forward;
+        vector<int>& q = sim.visitOrder;
+        visited.reset(g.vertexCount());
+
+        src = g.vertexOf(src);
+        q.push_back(src);
+        visited.set(src, 0, -1);
+
+        for (size_t head = 0; head < q.size(); ++head) {
+            int curr = q[head];
+
+            // Visit all neighbors
+            for (int e = g.offsets[curr]; e < g.offsets[curr + 1]; ++e) {
+                int neighbor = g.targets[e];
+                if (!visited.reached(neighbor)) {
+                    visited.set(neighbor, visited.distance(curr) + 1, curr);
+                    q.push_back(neighbor);
+                }
+            }
+        }
+
+        // Expand the stamped hop counts into the dense level array
+        sim.levels.assign(g.vertexCount(), -1);
+        for (int& v : q) {
+            v = g.locationOf(v);
+            sim.levels[v] = visited.distance(g.vertexOf(v));
+        }
+        return sim;
+    }
+
+    /*
+     * Finds the cheapest route between two locations, stopping as soon as
+     * the chosen search strategy can prove the destination's distance
      * @param from: Starting location
      * @param to: Destination location
-     * @param cost: Time or distance cost between locations
+     * @param mode: Search strategy to use
+     * @return: Path with its ETA, found == false if unreachable, and
+     *          status == Status::NotFound if either name is unknown
+     */
+    PathResult shortestPath(string_view from, string_view to,
+                            SearchMode mode = SearchMode::Dijkstra) const {
+        return shortestPath(from, to, mode, defaultWorkspace());
+    }
+
+    /*
+     * Point-to-point query reusing the caller's workspace
+     * @param from: Starting location
+     * @param to: Destination location
+     * @param mode: Search strategy to use
+     * @param ws: Workspace owned by the calling thread
+     * @return: Path with its ETA, found == false if unreachable, and
+     *          status == Status::NotFound if either name is unknown
      */
-    void addRoute(const string& from, const string& to, int cost) {
+    PathResult shortestPath(string_view from, string_view to, SearchMode mode,
+                            QueryWorkspace& ws) const {
         // Check if both locations exist
-        if (!locationToIndex.count(from) || !locationToIndex.count(to)) {
-            cout << "One or both locations not found.\n";
-            return;
+        int src = names.find(from), dst = names.find(to);
+        if (src < 0 || dst < 0) {
+            PathResult missing;
+            missing.status = Status::NotFound;
+            return missing;
         }
-        
-        // Get indices for both locations
-        int u = locationToIndex[from], v = locationToIndex[to];
-        
-        // Add to both adjacency lists (undirected graph)
-        adjList[u].push_back(make_pair(v, cost));
-        adjList[v].push_back(make_pair(u, cost));
-        
-        cout << "Route from '" << from << "' to '" << to << "' added with cost " << cost << ".\n";
+        QueryTimer timer(QueryKind::ShortestPath, src);
+
+        // Run against the frozen CSR snapshot, in its vertex numbering
+        shared_ptr<const CSRGraph> graph = frozenGraph();
+        src = graph->vertexOf(src);
+        dst = graph->vertexOf(dst);
+
+        switch (mode) {
+            case SearchMode::Bidirectional:
+                return bidirectionalSearch(*graph, src, dst, ws);
+            case SearchMode::AStar:
+                return aStarSearch(*graph, src, dst, ws);
+            case SearchMode::ALT:
+                return altSearch(*graph, src, dst, ws);
+            case SearchMode::ContractionHierarchy:
+                return hierarchySearch(*graph, src, dst, ws);
+            case SearchMode::Dijkstra:
+            default:
+                return dijkstraSearch(*graph, src, dst, ws);
+        }
+    }
+
+private:
+    /*
+     * Workspace used by the overloads that don't take one (one per thread)
+     */
+    static QueryWorkspace& defaultWorkspace() {
+        static thread_local QueryWorkspace ws;
+        return ws;
+    }
+
+    /*
+     * Unidirectional Dijkstra that stops once dst is settled
+     * @param g: Graph snapshot to search
+     * @param src: Origin index
+     * @param dst: Destination index
+     * @param ws: Workspace to run in
+     */
+    PathResult dijkstraSearch(const CSRGraph& g, int src, int dst, QueryWorkspace& ws) const {
+        PathResult result;
+        result.settledCount = runDijkstra(g, src, dst, heapKind, ws);
+
+        if (!ws.forward.reached(dst)) return result;
+        result.found = true;
+        result.eta = ws.forward.distance(dst);
+        result.stops = reconstructStops(g, ws.forward, dst);
+        return result;
+    }
+
+    /*
+     * Bidirectional Dijkstra: grows a forward frontier from src and a
+     * backward frontier from dst, always advancing the one with the smaller
+     * key. Routes are symmetric, so the backward search walks the same
+     * snapshot. Stops once topForward + topBackward >= best meeting cost.
+     * @param g: Graph snapshot to search
+     * @param src: Origin index
+     * @param dst: Destination index
+     * @param ws: Workspace to run in
+     */
+    PathResult bidirectionalSearch(const CSRGraph& g, int src, int dst, QueryWorkspace& ws) const {
+        const int INF = numeric_limits<int>::max();
+
+        PathResult result;
+        int n = g.vertexCount();
+        SearchSpace* space[2] = { &ws.forward, &ws.backward };
+        BinaryHeapQueue* pq = ws.sides;
+        for (int side = 0; side < 2; ++side) {
+            space[side]->reset(n);
+            pq[side].reset(n, 0);
+        }
+        space[0]->set(src, 0, -1); pq[0].push(0, src); // Forward side
+        space[1]->set(dst, 0, -1); pq[1].push(0, dst); // Backward side
+
+        int best = (src == dst) ? 0 : INF; // Cheapest src-dst path seen so far
+        int meet = (src == dst) ? src : -1; // Vertex where that path joins
+
+        while (!pq[0].empty() && !pq[1].empty()) {
+            // Meeting criterion: no unsettled vertex can improve on best
+            if (best != INF && (long long)pq[0].peekKey() + pq[1].peekKey() >= best) break;
+
+            // Advance the side whose frontier is closer
+            int side = (pq[0].peekKey() <= pq[1].peekKey()) ? 0 : 1;
+            pair<int, int> top = pq[side].pop();
+            int d = top.first;
+            int u = top.second;
+            if (d > space[side]->distance(u)) continue;
+            result.settledCount++;
+
+            SearchSpace& mine = *space[side];
+            const SearchSpace& other = *space[1 - side];
+            for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+                int v = g.targets[e];
+                int cost = g.costs[e];
+                if (mine.distance(v) > d + cost) {
+                    mine.set(v, d + cost, u);
+                    pq[side].push(d + cost, v);
+                }
+                // Check whether this edge links the two frontiers
+                if (other.reached(v) && (long long)d + cost + other.distance(v) < best) {
+                    best = d + cost + other.distance(v);
+                    meet = v;
+                }
+            }
+        }
+
+        if (best == INF) return result;
+        result.found = true;
+        result.eta = best;
+
+        // Forward half ends at meet; backward predecessors lead on to dst
+        result.stops = reconstructStops(g, ws.forward, meet);
+        for (int v = ws.backward.predecessor(meet); v != -1; v = ws.backward.predecessor(v)) {
+            result.stops.push_back(string(names.name(g.locationOf(v))));
+        }
+        return result;
+    }
+
+    /*
+     * A* search: Dijkstra ordered by dist + heuristic estimate to dst.
+     * Locations without coordinates (or a missing dst position) get a zero
+     * estimate, which degrades gracefully to plain Dijkstra.
+     * @param g: Graph snapshot to search
+     * @param src: Origin index
+     * @param dst: Destination index
+     * @param ws: Workspace to run in
+     */
+    PathResult aStarSearch(const CSRGraph& g, int src, int dst, QueryWorkspace& ws) const {
+        const GeoPoint& goal = coordinates[g.locationOf(dst)];
+        bool guided = heuristic && hasCoordinates[g.locationOf(dst)];
+        return goalDirectedSearch(g, src, dst, ws, [&](int v) {
+            int loc = g.locationOf(v);
+            return (guided && hasCoordinates[loc])
+                ? max(0, heuristic(coordinates[loc], goal)) : 0;
+        });
+    }
+
+    /*
+     * ALT search: A* using landmark triangle-inequality lower bounds.
+     * Falls back to plain Dijkstra if no tables match the current graph.
+     * @param g: Graph snapshot to search
+     * @param src: Origin index
+     * @param dst: Destination index
+     * @param ws: Workspace to run in
+     */
+    PathResult altSearch(const CSRGraph& g, int src, int dst, QueryWorkspace& ws) const {
+        const LandmarkTable* table = landmarkTable.get();
+        if (!table || table->landmarkCount() == 0) return dijkstraSearch(g, src, dst, ws);
+        return goalDirectedSearch(g, src, dst, ws, [&](int v) {
+            return table->lowerBound(v, dst);
+        });
+    }
+
+    /*
+     * Contraction hierarchy search.
+     * Falls back to plain Dijkstra if no hierarchy has been built.
+     * @param g: Graph snapshot to search
+     * @param src: Origin index
+     * @param dst: Destination index
+     * @param ws: Workspace to run in
+     */
+    PathResult hierarchySearch(const CSRGraph& g, int src, int dst, QueryWorkspace& ws) const {
+        if (!hierarchy) return dijkstraSearch(g, src, dst, ws);
+        PathResult result;
+        vector<int> path;
+        int distance = hierarchy->query(src, dst, path, result.settledCount, ws);
+        if (distance == numeric_limits<int>::max()) return result;
+        result.found = true;
+        result.eta = distance;
+        for (int v : path) result.stops.push_back(string(names.name(g.locationOf(v))));
+        return result;
+    }
+
+    /*
+     * Shared A* engine: Dijkstra ordered by dist + estimate(v).
+     * Vertices may be re-opened, so an admissible but inconsistent
+     * estimate still yields the exact shortest path.
+     * @param g: Graph snapshot to search
+     * @param src: Origin index
+     * @param dst: Destination index
+     * @param ws: Workspace to run in
+     * @param estimate: Admissible lower bound on the distance from v to dst
+     */
+    template <class Estimate>
+    PathResult goalDirectedSearch(const CSRGraph& g, int src, int dst, QueryWorkspace& ws,
+                                  Estimate estimate) const {
+        PathResult result;
+        int n = g.vertexCount();
+        SearchSpace& dist = ws.forward;
+        SearchSpace& cached = ws.estimates; // Estimate per vertex, computed once
+        dist.reset(n);
+        cached.reset(n);
+
+        auto h = [&](int v) {
+            if (!cached.reached(v)) cached.set(v, estimate(v), -1);
+            return cached.distance(v);
+        };
+
+        // Min-heap of (dist + estimate, vertex) in reusable storage
+        vector<pair<long long, int>>& heap = ws.goalHeap;
+        greater<pair<long long, int>> later;
+        heap.clear();
+        dist.set(src, 0, -1);
+        heap.push_back(make_pair((long long)h(src), src));
+
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end(), later);
+            pair<long long, int> top = heap.back(); heap.pop_back();
+            int u = top.second;
+            int du = dist.distance(u);
+
+            // Skip entries made stale by a later improvement
+            if (top.first > (long long)du + h(u)) continue;
+            result.settledCount++;
+            if (u == dst) break;
+
+            for (int e = g.offsets[u]; e < g.offsets[u + 1]; ++e) {
+                int v = g.targets[e];
+                int cost = g.costs[e];
+                if (dist.distance(v) > du + cost) {
+                    dist.set(v, du + cost, u);
+                    heap.push_back(make_pair((long long)du + cost + h(v), v));
+                    push_heap(heap.begin(), heap.end(), later);
+                }
+            }
+        }
+
+        if (!dist.reached(dst)) return result;
+        result.found = true;
+        result.eta = dist.distance(dst);
+        result.stops = reconstructStops(g, dist, dst);
+        return result;
+    }
+};
+
+/*
+ * ConcurrentDeliveryPathOptimizer class
+ * Read-copy-update front end that lets query threads run alongside a
+ * writer. Readers take the published version, an immutable optimizer from
+ * readOnlyCopy(), and query it without locking. Writers apply a batch of
+ * mutations to a private master optimizer under a writer mutex and then
+ * publish its next version with one atomic pointer store. A version is
+ * reclaimed by its reference count once the last reader holding it lets
+ * go, so readers never wait for writers and writers never wait for readers.
+ */
+class ConcurrentDeliveryPathOptimizer {
+public:
+    ConcurrentDeliveryPathOptimizer() : published(master.readOnlyCopy()) {}
+
+    /*
+     * Returns the latest published version for queries. Keep the pointer
+     * for a consistent view across several queries; the version it points
+     * to never changes, whatever is published meanwhile.
+     */
+    shared_ptr<const DeliveryPathOptimizer> current() const {
+        return atomic_load(&published);
+    }
+
+    /*
+     * Applies a batch of mutations and publishes the result. Batching many
+     * mutations per call amortizes the freeze that publishing costs.
+     * @param batch: Called with the master optimizer (collect any Status
+     *               results inside it)
+     * @return: graphVersion() of the newly published version
+     */
+    uint64_t update(const function<void(DeliveryPathOptimizer&)>& batch) {
+        lock_guard<mutex> guard(writer);
+        batch(master);
+        shared_ptr<const DeliveryPathOptimizer> next = master.readOnlyCopy();
+        atomic_store(&published, next);
+        return next->graphVersion();
+    }
+
+private:
+    mutex writer;                                       // Serializes update()
+    DeliveryPathOptimizer master;                       // Writer-side state (guarded by writer)
+    shared_ptr<const DeliveryPathOptimizer> published;  // Readers' version (atomic access only)
+};
+
+// Define DELPATHOPT_NO_MAIN to embed the optimizer without the menu
+// (the benchmark suite includes this file that way)
+#ifndef DELPATHOPT_NO_MAIN
+
+/*
+ * Splits a comma-separated list of location names
+ * @param text: Input line such as "Depot,Store A,Store B"
+ */
+static vector<string> splitCommaList(const string& text) {
+    vector<string> items;
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = text.find(',', begin);
+        if (end == string::npos) end = text.size();
+        if (end > begin) items.push_back(text.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return items;
+}
+
+/*
+ * Displays all locations in the system
+ * @param dpo: Optimizer to list
+ */
+static void printLocations(const DeliveryPathOptimizer& dpo) {
+    cout << "\nLocations:\n";
+    for (int i = 0; i < dpo.indexCount(); ++i) {
+        if (!dpo.isLive(i)) continue; // Skip tombstoned slots
+        cout << "- " << dpo.locationName(i) << "\n";
+    }
+}
+
+/*
+ * Displays a delivery plan as ETA and cost per location
+ * @param dpo: Optimizer the plan was computed on
+ * @param plan: Result of optimizeDeliveryPlan
+ */
+static void printDeliveryPlan(const DeliveryPathOptimizer& dpo, const ShortestPathTree& plan) {
+    if (!plan.found) {
+        cout << "Starting location not found.\n";
+        return;
+    }
+    cout << "\n--- Optimized Delivery Plan from '" << plan.origin << "' ---\n";
+    for (int i = 0; i < (int)plan.distances.size(); ++i) {
+        if (!dpo.isLive(i)) continue; // Skip tombstoned slots
+        cout << dpo.locationName(i) << ": ";
+        if (plan.distances[i] == numeric_limits<int>::max())
+            cout << "Unreachable\n";
+        else
+            // Assuming cost is 5 times the time (example conversion)
+            cout << "ETA = " << plan.distances[i] << ", Cost = " << plan.distances[i] * 5 << "\n";
+    }
+}
+
+/*
+ * Displays a simulated delivery round in visit order
+ * @param dpo: Optimizer the simulation ran on
+ * @param sim: Result of simulateDelivery
+ */
+static void printSimulation(const DeliveryPathOptimizer& dpo, const RouteSimulation& sim) {
+    if (!sim.found) {
+        cout << "Starting location not found.\n";
+        return;
+    }
+    cout << "\n--- Route Simulation ---\n";
+    for (int v : sim.visitOrder) {
+        cout << "Delivering to: " << dpo.locationName(v) << "\n";
+    }
+}
+
+/*
+ * WorkerPool class
+ * Fixed set of threads running submitted tasks in FIFO order, for the
+ * server mode's concurrent queries
+ */
+class WorkerPool {
+public:
+    explicit WorkerPool(int threads) {
+        if (threads <= 0) threads = max(1u, thread::hardware_concurrency());
+        for (int t = 0; t < threads; ++t) workers.emplace_back([this] { run(); });
+    }
+
+    // Finishes every queued task, then joins the threads
+    ~WorkerPool() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    void submit(function<void()> task) {
+        {
+            lock_guard<mutex> guard(lock);
+            tasks.push_back(move(task));
+        }
+        ready.notify_one();
     }
 
-    /*
-     * Removes a route between two locations
-     * @param from: Starting location
-     * @param to: Destination location
-     */
-    void removeRoute(const string& from, const string& to) {
-        // Check if both locations exist
-        if (!locationToIndex.count(from) || !locationToIndex.count(to)) {
-            cout << "One or both locations not found.\n";
-            return;
+private:
+    void run() {
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock<mutex> guard(lock);
+                ready.wait(guard, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
         }
-        
-        // Get indices for both locations
-        int u = locationToIndex[from], v = locationToIndex[to];
+    }
 
-        // Remove from first location's adjacency list
-        auto& listU = adjList[u];
-        listU.erase(remove_if(listU.begin(), listU.end(),
-            [v](const pair<int, int>& p) { return p.first == v; }), listU.end());
+    mutex lock;
+    condition_variable ready;
+    deque<function<void()>> tasks;
+    bool stopping = false;
+    vector<thread> workers;
+};
 
-        // Remove from second location's adjacency list
-        auto& listV = adjList[v];
-        listV.erase(remove_if(listV.begin(), listV.end(),
-            [u](const pair<int, int>& p) { return p.first == u; }), listV.end());
+/*
+ * ResponseSink class
+ * Output side of one command stream. Response lines are appended to a
+ * buffer that is written out once it holds FLUSH_BYTES, or as soon as no
+ * request is in flight, so pipelining clients get large writes and a
+ * client waiting on one answer is never left behind a partial buffer.
+ */
+class ResponseSink {
+public:
+    static const size_t FLUSH_BYTES = 64 << 10;
 
-        cout << "Route between '" << from << "' and '" << to << "' removed.\n";
+    explicit ResponseSink(int fd) : fd(fd) {}
+
+    // Marks a request as in flight
+    void begin() {
+        lock_guard<mutex> guard(lock);
+        inFlight++;
     }
 
-    /*
-     * Displays all locations in the system
-     */
-    void showLocations() const {
-        cout << "\nLocations:\n";
-        for (const auto& name : indexToLocation) {
-            cout << "- " << name << "\n";
-        }
+    // Queues the response line of an in-flight request
+    void finish(const string& line) {
+        lock_guard<mutex> guard(lock);
+        buffer += line;
+        buffer += '\n';
+        if (--inFlight == 0 || buffer.size() >= FLUSH_BYTES) flushLocked();
+        if (inFlight == 0) idle.notify_all();
     }
 
-    /*
-     * Calculates and displays optimal delivery paths from a starting location
-     * using Dijkstra's algorithm
-     * @param start: Starting location for path calculation
-     */
-    void optimizeDeliveryPlan(const string& start) const {
-        // Check if starting location exists
-        if (!locationToIndex.count(start)) {
-            cout << "Starting location not found.\n";
-            return;
+    // Waits until every in-flight request has been answered and written
+    void drain() {
+        unique_lock<mutex> guard(lock);
+        idle.wait(guard, [this] { return inFlight == 0; });
+        flushLocked();
+    }
+
+private:
+    void flushLocked() {
+        size_t done = 0;
+        while (done < buffer.size()) {
+            ssize_t n = ::write(fd, buffer.data() + done, buffer.size() - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break; // Client has gone; drop what is left
+            done += n;
         }
+        buffer.clear();
+    }
 
-        // Initialize distance vector with "infinity"
-        int n = locationCount;
-        vector<int> dist(n, numeric_limits<int>::max());
-        
-        // Distance to start is 0
-        int src = locationToIndex.at(start);
-        dist[src] = 0;
+    int fd;
+    mutex lock;
+    condition_variable idle;
+    string buffer;
+    int inFlight = 0;
+};
 
-        // Priority queue for Dijkstra's algorithm (min-heap)
-        // Stores pairs of (distance, vertex_index)
-        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
-        pq.push(make_pair(0, src));
+/*
+ * Splits a protocol line into fields: tab-separated, or space-separated
+ * when the line has no tab (names with spaces need tabs)
+ * @param line: Command line without its newline
+ */
+static vector<string> splitFields(const string& line) {
+    char separator = (line.find('\t') != string::npos) ? '\t' : ' ';
+    vector<string> fields;
+    size_t begin = 0;
+    while (begin <= line.size()) {
+        size_t end = line.find(separator, begin);
+        if (end == string::npos) end = line.size();
+        if (end > begin || separator == '\t') fields.push_back(line.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return fields;
+}
 
-        // Main Dijkstra's algorithm loop
-        while (!pq.empty()) {
-            pair<int, int> top = pq.top(); pq.pop();
-            int d = top.first;  // Current distance
-            int u = top.second; // Current vertex
+// Protocol spelling of a status
+static const char* statusName(Status status) {
+    switch (status) {
+        case Status::Ok: return "ok";
+        case Status::NotFound: return "not_found";
+        case Status::AlreadyExists: return "already_exists";
+        case Status::InvalidArgument: return "invalid_argument";
+        case Status::NothingToDo: return "nothing_to_do";
+        case Status::IoError: return "io_error";
+        case Status::StaleData: return "stale_data";
+    }
+    return "error";
+}
 
-            // Skip if we've already found a better path
-            if (d > dist[u]) continue;
+// Parses a whole protocol field as a number
+template<class T>
+static bool parseNumber(const string& field, T& value) {
+    return parseField(field.data(), field.data() + field.size(), value);
+}
 
-            // Explore all neighbors
-            for (size_t i = 0; i < adjList[u].size(); ++i) {
-                int v = adjList[u][i].first;       // Neighbor index
-                int cost = adjList[u][i].second;    // Edge cost
-                
-                // Relaxation step
-                if (dist[v] > dist[u] + cost) {
-                    dist[v] = dist[u] + cost;       // Update distance
-                    pq.push(make_pair(dist[v], v)); // Add to queue
-                }
-            }
-        }
+// Response line of a command that only reports a status
+static string statusLine(const string& id, Status status) {
+    return id + (status == Status::Ok ? "\tok" : string("\terror\t") + statusName(status));
+}
 
-        // Display results
-        cout << "\n--- Optimized Delivery Plan from '" << start << "' ---\n";
-        for (int i = 0; i < n; ++i) {
-            cout << indexToLocation[i] << ": ";
-            if (dist[i] == numeric_limits<int>::max())
-                cout << "Unreachable\n";
-            else
-                // Assuming cost is 5 times the time (example conversion)
-                cout << "ETA = " << dist[i] << ", Cost = " << dist[i] * 5 << "\n";
-        }
+// Whether a command changes the network (applied in stream order by the reader)
+static bool isMutation(const string& command) {
+    return command == "add_location" || command == "remove_location" || command == "add_route" ||
+           command == "remove_route" || command == "update_route" || command == "import" ||
+           command == "load_snapshot" || command == "build_landmarks" || command == "build_hierarchy";
+}
+
+// Mutations that serveStream queues in a batch instead of applying one by one
+static bool isBatchedMutation(const string& command) {
+    return command == "add_location" || command == "add_route" || command == "remove_route" ||
+           command == "update_route";
+}
+
+/*
+ * Applies one mutation command
+ * @param dpo: Writer-side optimizer
+ * @param f: Fields (request ID, command, arguments)
+ * @return: Response line
+ */
+static string runMutation(DeliveryPathOptimizer& dpo, const vector<string>& f) {
+    const string& id = f[0];
+    const string& command = f[1];
+    size_t args = f.size() - 2;
+    int number;
+    if (command == "add_location" && args == 1) return statusLine(id, dpo.addLocation(f[2]));
+    if (command == "add_location" && args == 3) {
+        double lat, lon;
+        if (!parseNumber(f[3], lat) || !parseNumber(f[4], lon)) return statusLine(id, Status::InvalidArgument);
+        return statusLine(id, dpo.addLocation(f[2], lat, lon));
     }
+    if (command == "remove_location" && args == 1) return statusLine(id, dpo.removeLocation(f[2]));
+    if ((command == "add_route" || command == "update_route") && args == 3) {
+        if (!parseNumber(f[4], number)) return statusLine(id, Status::InvalidArgument);
+        return statusLine(id, command == "add_route" ? dpo.addRoute(f[2], f[3], number)
+                                                     : dpo.updateRouteCost(f[2], f[3], number));
+    }
+    if (command == "remove_route" && args == 2) return statusLine(id, dpo.removeRoute(f[2], f[3]));
+    if (command == "import" && args == 2) {
+        ImportReport report = dpo.importGraph(f[2], f[3]);
+        if (report.status != Status::Ok) return statusLine(id, report.status);
+        return id + "\tok\t" + to_string(report.locationsAdded) + "\t" + to_string(report.routesAdded);
+    }
+    if (command == "load_snapshot" && args == 1) return statusLine(id, dpo.loadSnapshot(f[2]));
+    if (command == "build_landmarks" && args == 1) {
+        if (!parseNumber(f[2], number)) return statusLine(id, Status::InvalidArgument);
+        return statusLine(id, dpo.buildLandmarks(number));
+    }
+    if (command == "build_hierarchy" && args == 0) {
+        return id + "\tok\t" + to_string(dpo.buildContractionHierarchy());
+    }
+    return statusLine(id, Status::InvalidArgument);
+}
 
-    /*
-     * Simulates delivery route using Breadth-First Search (BFS)
-     * @param start: Starting location for simulation
-     */
-    void simulateDelivery(const string& start) const {
-        // Check if starting location exists
-        if (!locationToIndex.count(start)) {
-            cout << "Starting location not found.\n";
-            return;
+/*
+ * Answers one query command on a published version
+ * @param dpo: Immutable version to query
+ * @param f: Fields (request ID, command, arguments)
+ * @return: Response line
+ */
+static string runQuery(const DeliveryPathOptimizer& dpo, const vector<string>& f) {
+    const string& id = f[0];
+    const string& command = f[1];
+    size_t args = f.size() - 2;
+    string line = id + "\tok";
+    if (command == "ping" && args == 0) return line;
+    if (command == "plan" && args == 1) {
+        ShortestPathTree plan = dpo.optimizeDeliveryPlan(f[2]);
+        if (!plan.found) return statusLine(id, Status::NotFound);
+        for (int i = 0; i < (int)plan.distances.size(); ++i) {
+            if (!dpo.isLive(i) || plan.distances[i] == numeric_limits<int>::max()) continue;
+            line += "\t";
+            line += dpo.locationName(i);
+            line += "\t" + to_string(plan.distances[i]);
+        }
+        return line;
+    }
+    if (command == "path" && (args == 2 || args == 3)) {
+        SearchMode mode = SearchMode::Dijkstra;
+        if (args == 3) {
+            if (f[4] == "bidirectional") mode = SearchMode::Bidirectional;
+            else if (f[4] == "astar") mode = SearchMode::AStar;
+            else if (f[4] == "alt") mode = SearchMode::ALT;
+            else if (f[4] == "ch") mode = SearchMode::ContractionHierarchy;
+            else if (f[4] != "dijkstra") return statusLine(id, Status::InvalidArgument);
+        }
+        PathResult result = dpo.shortestPath(f[2], f[3], mode);
+        if (result.status != Status::Ok) return statusLine(id, result.status);
+        if (!result.found) return id + "\terror\tunreachable";
+        line += "\t" + to_string(result.eta);
+        for (const string& stop : result.stops) line += "\t" + stop;
+        return line;
+    }
+    if (command == "area" && args == 2) {
+        int limit;
+        if (!parseNumber(f[3], limit)) return statusLine(id, Status::InvalidArgument);
+        ServiceArea area = dpo.serviceArea(f[2], limit);
+        if (!area.found) return statusLine(id, Status::NotFound);
+        for (const auto& stop : area.reached) {
+            line += "\t";
+            line += dpo.locationName(stop.first);
+            line += "\t" + to_string(stop.second);
         }
+        return line;
+    }
+    if (command == "tour" && args >= 1) {
+        vector<string> stops(f.begin() + 3, f.end());
+        DeliveryTour tour = dpo.planDeliveryTour(f[2], stops, false, DeliveryPathOptimizer::DEFAULT_TOUR_BUDGET_MS, 1);
+        if (tour.status != Status::Ok) return statusLine(id, tour.status);
+        line += "\t" + to_string(tour.eta);
+        for (const string& stop : tour.stops) line += "\t" + stop;
+        return line;
+    }
+    if (isMutation(command) || command == "ping" || command == "plan" || command == "path" ||
+        command == "area" || command == "tour") {
+        return statusLine(id, Status::InvalidArgument); // Known command, wrong arguments
+    }
+    return id + "\terror\tunknown_command";
+}
 
-        // BFS initialization
-        queue<int> q;                   // Queue for BFS
-        vector<bool> visited(locationCount, false); // Visited markers
-        int src = locationToIndex.at(start); // Starting index
+/*
+ * Serves one command stream until end of input. Each line is
+ * "<id> <command> <args...>" and is answered by one line starting with the
+ * same ID, "ok" or "error", and the result fields. Queries run concurrently
+ * on the worker pool, so answers can arrive out of order. Mutations are
+ * applied by the reader in stream order, grouped per input chunk into one
+ * published version, and every query sees all mutations sent before it.
+ * Route changes within a group are applied as one batch.
+ * @param inFd: Input descriptor (stdin or a connection)
+ * @param outFd: Output descriptor
+ * @param service: Network shared by every stream
+ * @param pool: Worker threads for queries
+ */
+static void serveStream(int inFd, int outFd, ConcurrentDeliveryPathOptimizer& service, WorkerPool& pool) {
+    ResponseSink sink(outFd);
+    vector<vector<string>> mutations; // Parsed but not yet applied
+    auto publish = [&]() {
+        if (mutations.empty()) return;
+        vector<string> responses;
+        service.update([&](DeliveryPathOptimizer& dpo) {
+            dpo.beginBatch();
+            for (const auto& f : mutations) {
+                // Commands that renumber or build on the network see every
+                // route change queued before them
+                bool queued = isBatchedMutation(f[1]);
+                if (!queued) dpo.commitBatch();
+                responses.push_back(runMutation(dpo, f));
+                if (!queued) dpo.beginBatch();
+            }
+            dpo.commitBatch();
+        });
+        for (const string& response : responses) {
+            sink.begin();
+            sink.finish(response);
+        }
+        mutations.clear();
+    };
 
-        q.push(src);
-        visited[src] = true;
+    string pending; // Bytes after the last complete line
+    char chunk[64 << 10];
+    while (true) {
+        ssize_t n = ::read(inFd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        pending.append(chunk, n);
 
-        cout << "\n--- Route Simulation ---\n";
-        while (!q.empty()) {
-            int curr = q.front(); q.pop();
-            cout << "Delivering to: " << indexToLocation[curr] << "\n";
+        size_t begin = 0, end;
+        while ((end = pending.find('\n', begin)) != string::npos) {
+            string line = pending.substr(begin, end - begin);
+            begin = end + 1;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
 
-            // Visit all neighbors
-            for (size_t i = 0; i < adjList[curr].size(); ++i) {
-                int neighbor = adjList[curr][i].first;
-                if (!visited[neighbor]) {
-                    visited[neighbor] = true;
-                    q.push(neighbor);
-                }
+            vector<string> fields = splitFields(line);
+            if (fields.size() < 2) {
+                sink.begin();
+                sink.finish((fields.empty() ? string("-") : fields[0]) + "\terror\tinvalid_argument");
+                continue;
             }
+            if (isMutation(fields[1])) {
+                mutations.push_back(move(fields));
+                continue;
+            }
+
+            // Queries run on the newest version, after pending mutations
+            publish();
+            shared_ptr<const DeliveryPathOptimizer> version = service.current();
+            sink.begin();
+            pool.submit([version, fields, &sink]() { sink.finish(runQuery(*version, fields)); });
         }
+        pending.erase(0, begin);
+        publish(); // Don't hold mutations back while the client waits
     }
-};
+    publish();
+    sink.drain();
+}
+
+/*
+ * Accepts TCP connections on a loopback port and serves each one as a command
+ * stream on its own reader thread, sharing the network and worker pool
+ * @param port: Port to listen on
+ * @param service: Network shared by every connection
+ * @param pool: Worker threads for queries
+ * @return: False if the port could not be bound, true once accept fails and
+ *          every connection has been served
+ */
+static bool serveSocket(int port, ConcurrentDeliveryPathOptimizer& service, WorkerPool& pool) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) return false;
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t)port);
+    if (::bind(listener, (sockaddr*)&address, sizeof(address)) < 0 || listen(listener, 64) < 0) {
+        close(listener);
+        return false;
+    }
+    signal(SIGPIPE, SIG_IGN); // A client closing early must not end the server
+
+    // Connection threads use service and pool, so they are joined before
+    // returning rather than detached; finished ones are reaped on each accept
+    struct Connection {
+        thread reader;
+        shared_ptr<atomic<bool>> done;
+    };
+    vector<Connection> connections;
+    while (true) {
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        int noDelay = 1;
+        setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        connections.erase(remove_if(connections.begin(), connections.end(), [](Connection& c) {
+            if (!c.done->load()) return false;
+            c.reader.join();
+            return true;
+        }), connections.end());
+        auto done = make_shared<atomic<bool>>(false);
+        connections.push_back({thread([connection, done, &service, &pool]() {
+            serveStream(connection, connection, service, pool);
+            close(connection);
+            done->store(true);
+        }), done});
+    }
+    close(listener);
+    for (Connection& c : connections) c.reader.join();
+    return true;
+}
 
 /*
  * Main Driver Menu
- * Provides interactive interface for using the DeliveryPathOptimizer
+ * Provides interactive interface for using the DeliveryPathOptimizer.
+ * "--serve" answers the line protocol of serveStream() on stdin/stdout
+ * instead, and "--listen PORT" on loopback TCP connections; both take
+ * "--threads N" to size the query pool.
  */
-int main() {
+int main(int argc, char* argv[]) {
+    int listenPort = -1, threads = 0;
+    bool serve = false;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--serve") serve = true;
+        else if (arg == "--listen" && i + 1 < argc) listenPort = atoi(argv[++i]);
+        else if (arg == "--threads" && i + 1 < argc) threads = atoi(argv[++i]);
+        else {
+            cerr << "Usage: " << argv[0] << " [--serve | --listen PORT] [--threads N]\n";
+            return 2;
+        }
+    }
+    if (serve || listenPort >= 0) {
+        ConcurrentDeliveryPathOptimizer service;
+        WorkerPool pool(threads);
+        if (listenPort < 0) {
+            serveStream(0, 1, service, pool);
+            return 0;
+        }
+        if (!serveSocket(listenPort, service, pool)) {
+            cerr << "Cannot listen on port " << listenPort << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    ios::sync_with_stdio(false); // Only iostreams are used; skip C stdio syncing
     DeliveryPathOptimizer dpo; // Create optimizer instance
     string input;              // For user input
     int choice;                // Menu choice
@@ -278,6 +5866,14 @@ int main() {
         cout << "\n=== Delivery Path Optimizer Menu ===\n";
         cout << "1. Add Location\n2. Remove Location\n3. Add Route\n4. Remove Route\n";
         cout << "5. Show Locations\n6. Optimize Delivery Plan\n7. Simulate Route\n8. Exit\n";
+        cout << "9. Compact Locations\n10. Find Shortest Path\n11. Add Location With Coordinates\n";
+        cout << "12. Build Landmarks\n13. Save Landmarks\n14. Load Landmarks\n";
+        cout << "15. Build Contraction Hierarchy\n16. Batch Optimize\n17. Distance Matrix\n";
+        cout << "18. Import Graph\n19. Save Graph Snapshot\n20. Load Graph Snapshot\n";
+        cout << "21. Update Route Cost\n22. Track Delivery Source\n23. Cache Statistics\n";
+        cout << "24. Parallel Delivery Plan\n25. Hop-Count Zones\n26. Set Vertex Order\n";
+        cout << "27. Set Route Profile\n28. Delivery Plan At Departure\n29. Plan Delivery Tour\n";
+        cout << "30. Service Area\n31. Show Metrics\n";
         cout << "Enter choice: ";
         getline(cin, input);
 
@@ -294,13 +5890,19 @@ int main() {
             case 1: // Add Location
                 cout << "Enter location name: ";
                 getline(cin, loc1);
-                dpo.addLocation(loc1);
+                if (dpo.addLocation(loc1) == Status::AlreadyExists)
+                    cout << "Location already exists.\n";
+                else
+                    cout << "Location '" << loc1 << "' added.\n";
                 break;
                 
             case 2: // Remove Location
                 cout << "Enter location name to remove: ";
                 getline(cin, loc1);
-                dpo.removeLocation(loc1);
+                if (dpo.removeLocation(loc1) == Status::NotFound)
+                    cout << "Location not found.\n";
+                else
+                    cout << "Location '" << loc1 << "' removed.\n";
                 break;
                 
             case 3: // Add Route
@@ -312,9 +5914,19 @@ int main() {
                 getline(cin, input);
                 try {
                     cost = stoi(input);
-                    dpo.addRoute(loc1, loc2, cost);
                 } catch (...) {
                     cout << "Invalid cost input.\n";
+                    break;
+                }
+                switch (dpo.addRoute(loc1, loc2, cost)) {
+                    case Status::NotFound:
+                        cout << "One or both locations not found.\n";
+                        break;
+                    case Status::InvalidArgument:
+                        cout << "Cost " << cost << " is out of range for this build.\n";
+                        break;
+                    default:
+                        cout << "Route from '" << loc1 << "' to '" << loc2 << "' added with cost " << cost << ".\n";
                 }
                 break;
                 
@@ -323,32 +5935,419 @@ int main() {
                 getline(cin, loc1);
                 cout << "Enter TO location: ";
                 getline(cin, loc2);
-                dpo.removeRoute(loc1, loc2);
+                if (dpo.removeRoute(loc1, loc2) == Status::NotFound)
+                    cout << "One or both locations not found.\n";
+                else
+                    cout << "Route between '" << loc1 << "' and '" << loc2 << "' removed.\n";
                 break;
                 
             case 5: // Show Locations
-                dpo.showLocations();
+                printLocations(dpo);
                 break;
                 
             case 6: // Optimize Delivery Plan
                 cout << "Enter starting location: ";
                 getline(cin, loc1);
-                dpo.optimizeDeliveryPlan(loc1);
+                printDeliveryPlan(dpo, dpo.optimizeDeliveryPlan(loc1));
                 break;
                 
             case 7: // Simulate Route
                 cout << "Enter starting location for simulation: ";
                 getline(cin, loc1);
-                dpo.simulateDelivery(loc1);
+                printSimulation(dpo, dpo.simulateDelivery(loc1));
                 break;
                 
             case 8: // Exit
                 cout << "Exiting...\n";
                 return 0;
                 
+            case 9: { // Compact Locations
+                int reclaimed = dpo.compact();
+                if (reclaimed == 0)
+                    cout << "Nothing to compact.\n";
+                else
+                    cout << "Compacted " << reclaimed << " removed location slot(s).\n";
+                break;
+            }
+                
+            case 10: { // Find Shortest Path
+                cout << "Enter FROM location: ";
+                getline(cin, loc1);
+                cout << "Enter TO location: ";
+                getline(cin, loc2);
+                cout << "Search mode (1 = Dijkstra, 2 = Bidirectional, 3 = A*, 4 = ALT, 5 = CH) [1]: ";
+                getline(cin, input);
+                SearchMode mode = SearchMode::Dijkstra;
+                if (input == "2") mode = SearchMode::Bidirectional;
+                else if (input == "3") mode = SearchMode::AStar;
+                else if (input == "4") mode = SearchMode::ALT;
+                else if (input == "5") mode = SearchMode::ContractionHierarchy;
+                PathResult path = dpo.shortestPath(loc1, loc2, mode);
+                if (path.status == Status::NotFound) {
+                    cout << "One or both locations not found.\n";
+                    break;
+                }
+                if (!path.found) {
+                    cout << "No route found.\n";
+                    break;
+                }
+                cout << "\n--- Shortest Path ---\n";
+                for (size_t i = 0; i < path.stops.size(); ++i) {
+                    cout << (i ? " -> " : "") << path.stops[i];
+                }
+                cout << "\nETA = " << path.eta << ", Cost = " << path.eta * 5 << "\n";
+                break;
+            }
+                
+            case 11: { // Add Location With Coordinates
+                cout << "Enter location name: ";
+                getline(cin, loc1);
+                cout << "Enter latitude and longitude (e.g. 52.52 13.40): ";
+                getline(cin, input);
+                double lat, lon;
+                if (sscanf(input.c_str(), "%lf %lf", &lat, &lon) != 2)
+                    cout << "Invalid coordinates.\n";
+                else if (dpo.addLocation(loc1, lat, lon) == Status::AlreadyExists)
+                    cout << "Location already exists.\n";
+                else
+                    cout << "Location '" << loc1 << "' added.\n";
+                break;
+            }
+                
+            case 12: // Build Landmarks
+                cout << "Enter number of landmarks: ";
+                getline(cin, input);
+                try {
+                    if (dpo.buildLandmarks(stoi(input)) == Status::InvalidArgument)
+                        cout << "Landmark count must be positive.\n";
+                    else
+                        cout << "Built " << dpo.landmarkCount() << " landmark(s).\n";
+                } catch (...) {
+                    cout << "Invalid landmark count.\n";
+                }
+                break;
+                
+            case 13: { // Save Landmarks
+                cout << "Enter file path: ";
+                getline(cin, input);
+                Status status = dpo.saveLandmarks(input);
+                if (status == Status::NotFound)
+                    cout << "No landmarks built.\n";
+                else if (status == Status::IoError)
+                    cout << "Failed to write '" << input << "'.\n";
+                else
+                    cout << "Landmarks saved to '" << input << "'.\n";
+                break;
+            }
+                
+            case 14: { // Load Landmarks
+                cout << "Enter file path: ";
+                getline(cin, input);
+                Status status = dpo.loadLandmarks(input);
+                if (status == Status::IoError)
+                    cout << "Failed to read landmarks from '" << input << "'.\n";
+                else if (status == Status::StaleData)
+                    cout << "Landmarks were built for a different graph version.\n";
+                else
+                    cout << "Loaded " << dpo.landmarkCount() << " landmark(s).\n";
+                break;
+            }
+                
+            case 15: // Build Contraction Hierarchy
+                cout << "Contraction hierarchy built with " << dpo.buildContractionHierarchy()
+                     << " shortcut(s).\n";
+                break;
+                
+            case 16: { // Batch Optimize
+                cout << "Enter starting locations separated by commas: ";
+                getline(cin, input);
+                vector<ShortestPathTree> trees = dpo.batchOptimize(splitCommaList(input));
+                cout << "\n--- Batch Results ---\n";
+                for (const auto& tree : trees) {
+                    if (!tree.found) {
+                        cout << tree.origin << ": Starting location not found.\n";
+                        continue;
+                    }
+                    int reachable = 0;
+                    for (int d : tree.distances) {
+                        if (d != numeric_limits<int>::max()) reachable++;
+                    }
+                    cout << tree.origin << ": " << reachable << " location(s) reachable\n";
+                }
+                break;
+            }
+                
+            case 17: { // Distance Matrix
+                cout << "Enter locations separated by commas: ";
+                getline(cin, input);
+                vector<string> stops = splitCommaList(input);
+                DistanceMatrix matrix = dpo.distanceMatrix(stops, stops);
+                cout << "\n--- Distance Matrix ---\n";
+                for (int i = 0; i < matrix.rows; ++i) {
+                    cout << stops[i] << ":";
+                    for (int j = 0; j < matrix.cols; ++j) {
+                        if (matrix.at(i, j) == numeric_limits<int>::max())
+                            cout << " -";
+                        else
+                            cout << " " << matrix.at(i, j);
+                    }
+                    cout << "\n";
+                }
+                break;
+            }
+                
+            case 18: { // Import Graph
+                cout << "Enter locations file (blank to skip): ";
+                getline(cin, loc1);
+                cout << "Enter routes file: ";
+                getline(cin, loc2);
+                ImportReport report = dpo.importGraph(loc1, loc2);
+                if (report.status == Status::IoError) {
+                    cout << "Failed to read input files.\n";
+                    break;
+                }
+                cout << "Imported " << report.locationsAdded << " location(s) and "
+                     << report.routesAdded << " route(s) in " << report.seconds << " s ("
+                     << (long long)report.edgesPerSecond() << " edges/s), skipped "
+                     << report.linesSkipped << " line(s).\n";
+                break;
+            }
+                
+            case 19: // Save Graph Snapshot
+                cout << "Enter file path: ";
+                getline(cin, input);
+                if (dpo.saveSnapshot(input) == Status::IoError)
+                    cout << "Failed to write '" << input << "'.\n";
+                else
+                    cout << "Graph snapshot saved to '" << input << "'.\n";
+                break;
+                
+            case 20: { // Load Graph Snapshot
+                cout << "Enter file path: ";
+                getline(cin, input);
+                auto started = chrono::steady_clock::now();
+                if (dpo.loadSnapshot(input) == Status::IoError) {
+                    cout << "Failed to read graph snapshot from '" << input << "'.\n";
+                    break;
+                }
+                double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - started).count();
+                cout << "Loaded graph snapshot with " << dpo.liveLocationCount() << " location(s) in "
+                     << ms << " ms.\n";
+                break;
+            }
+                
+            case 21: // Update Route Cost
+                cout << "Enter FROM location: ";
+                getline(cin, loc1);
+                cout << "Enter TO location: ";
+                getline(cin, loc2);
+                cout << "Enter new cost/time: ";
+                getline(cin, input);
+                try {
+                    cost = stoi(input);
+                } catch (...) {
+                    cout << "Invalid cost input.\n";
+                    break;
+                }
+                switch (dpo.updateRouteCost(loc1, loc2, cost)) {
+                    case Status::NotFound:
+                        cout << "Route not found.\n";
+                        break;
+                    case Status::InvalidArgument:
+                        cout << "Cost " << cost << " is out of range for this build.\n";
+                        break;
+                    default:
+                        cout << "Route between '" << loc1 << "' and '" << loc2 << "' now costs " << cost << ".\n";
+                }
+                break;
+                
+            case 22: { // Track Delivery Source
+                cout << "Enter location to track: ";
+                getline(cin, loc1);
+                Status status = dpo.trackSource(loc1);
+                if (status == Status::NotFound)
+                    cout << "Location not found.\n";
+                else if (status == Status::AlreadyExists)
+                    cout << "Location is already tracked.\n";
+                else
+                    cout << "Tracking '" << loc1 << "' for incremental updates.\n";
+                break;
+            }
+                
+            case 23: { // Cache Statistics
+                CacheStats stats = dpo.resultCacheStats();
+                cout << "\n--- Result Cache ---\n";
+                cout << "Hits: " << stats.hits << ", Misses: " << stats.misses
+                     << ", Evictions: " << stats.evictions << "\n";
+                cout << "Entries: " << stats.entries << ", Memory: " << stats.bytes << " / "
+                     << stats.capacityBytes << " bytes\n";
+                break;
+            }
+                
+            case 24: { // Parallel Delivery Plan
+                cout << "Enter starting location: ";
+                getline(cin, loc1);
+                cout << "Bucket width (blank = automatic): ";
+                getline(cin, input);
+                int delta = 0;
+                if (!input.empty()) {
+                    try {
+                        delta = stoi(input);
+                    } catch (...) {
+                        cout << "Invalid bucket width.\n";
+                        break;
+                    }
+                }
+                printDeliveryPlan(dpo, dpo.parallelDeliveryPlan(loc1, 0, delta));
+                break;
+            }
+                
+            case 25: { // Hop-Count Zones
+                cout << "Enter starting location: ";
+                getline(cin, loc1);
+                RouteSimulation sim = dpo.simulateDelivery(loc1, BfsMode::DirectionOptimizing);
+                if (!sim.found) {
+                    cout << "Starting location not found.\n";
+                    break;
+                }
+                cout << "\n--- Hop-Count Zones from '" << sim.origin << "' ---\n";
+                for (int i = 0; i < (int)sim.levels.size(); ++i) {
+                    if (!dpo.isLive(i)) continue; // Skip tombstoned slots
+                    cout << dpo.locationName(i) << ": ";
+                    if (sim.levels[i] < 0)
+                        cout << "Unreachable\n";
+                    else
+                        cout << sim.levels[i] << " hop(s)\n";
+                }
+                break;
+            }
+                
+            case 26: { // Set Vertex Order
+                cout << "Vertex order (1 = Insertion, 2 = BFS, 3 = Reverse Cuthill-McKee, 4 = Hilbert) [1]: ";
+                getline(cin, input);
+                VertexOrder order = VertexOrder::Insertion;
+                if (input == "2") order = VertexOrder::BFS;
+                else if (input == "3") order = VertexOrder::ReverseCuthillMcKee;
+                else if (input == "4") order = VertexOrder::Hilbert;
+                dpo.setVertexOrder(order);
+                cout << "Vertex order updated; takes effect at the next query.\n";
+                break;
+            }
+                
+            case 27: { // Set Route Profile
+                cout << "Enter FROM location: ";
+                getline(cin, loc1);
+                cout << "Enter TO location: ";
+                getline(cin, loc2);
+                cout << "Breakpoints as minute:cost separated by commas (blank to clear): ";
+                getline(cin, input);
+                if (input.empty()) {
+                    if (dpo.clearRouteProfile(loc1, loc2) == Status::Ok)
+                        cout << "Route profile cleared.\n";
+                    else
+                        cout << "Route has no profile.\n";
+                    break;
+                }
+                vector<pair<int, int>> points;
+                bool parsed = true;
+                for (const string& item : splitCommaList(input)) {
+                    pair<int, int> point;
+                    if (sscanf(item.c_str(), "%d:%d", &point.first, &point.second) != 2) parsed = false;
+                    points.push_back(point);
+                }
+                if (!parsed) {
+                    cout << "Invalid breakpoint input.\n";
+                    break;
+                }
+                switch (dpo.setRouteProfile(loc1, loc2, points)) {
+                    case Status::NotFound:
+                        cout << "Route not found.\n";
+                        break;
+                    case Status::InvalidArgument:
+                        cout << "Breakpoints must have increasing minutes below "
+                             << TravelProfiles::PERIOD << " and must not let a later departure arrive earlier.\n";
+                        break;
+                    default:
+                        cout << "Route profile set (" << dpo.profileCount() << " distinct profile(s) stored).\n";
+                }
+                break;
+            }
+                
+            case 28: { // Delivery Plan At Departure
+                cout << "Enter starting location: ";
+                getline(cin, loc1);
+                cout << "Departure minute of day: ";
+                getline(cin, input);
+                int departure;
+                try {
+                    departure = stoi(input);
+                } catch (...) {
+                    cout << "Invalid departure time.\n";
+                    break;
+                }
+                printDeliveryPlan(dpo, dpo.optimizeDeliveryPlanAt(loc1, departure));
+                break;
+            }
+                
+            case 29: { // Plan Delivery Tour
+                cout << "Enter starting location: ";
+                getline(cin, loc1);
+                cout << "Enter stops separated by commas: ";
+                getline(cin, input);
+                vector<string> stops = splitCommaList(input);
+                cout << "Return to start? (y/n) [n]: ";
+                getline(cin, input);
+                DeliveryTour tour = dpo.planDeliveryTour(loc1, stops, input == "y" || input == "Y");
+                if (tour.status == Status::NotFound) {
+                    cout << "Starting location not found.\n";
+                    break;
+                }
+                cout << "\n--- Delivery Tour from '" << loc1 << "' ---\n";
+                for (size_t i = 0; i < tour.stops.size(); ++i) {
+                    cout << i + 1 << ". " << tour.stops[i] << " (ETA = " << tour.arrivals[i] << ")\n";
+                }
+                for (const string& stop : tour.skipped) {
+                    cout << "Skipped '" << stop << "': unknown or unreachable.\n";
+                }
+                cout << "Total ETA = " << tour.eta << " (" << tour.moves << " improving move(s), "
+                     << tour.seconds * 1000 << " ms)\n";
+                break;
+            }
+                
+            case 30: { // Service Area
+                cout << "Enter starting location: ";
+                getline(cin, loc1);
+                cout << "Enter cost/time limit: ";
+                getline(cin, input);
+                int limit;
+                try {
+                    limit = stoi(input);
+                } catch (...) {
+                    cout << "Invalid limit.\n";
+                    break;
+                }
+                ServiceArea area = dpo.serviceArea(loc1, limit);
+                if (!area.found) {
+                    cout << "Starting location not found.\n";
+                    break;
+                }
+                cout << "\n--- Within " << area.limit << " of '" << area.origin << "' ---\n";
+                for (const auto& stop : area.reached) {
+                    cout << dpo.locationName(stop.first) << ": ETA = " << stop.second << "\n";
+                }
+                cout << area.reached.size() << " location(s)\n";
+                break;
+            }
+                
+            case 31: // Show Metrics
+                cout << dpo.metricsText();
+                break;
+                
             default:
                 cout << "Invalid choice. Try again.\n";
         }
     }
-    return 0;
+    return 0;
 }
+
+#endif // DELPATHOPT_NO_MAIN
@@ -0,0 +1,397 @@
+/*
+ * Delivery Path Optimizer - Benchmark Suite
+ *
+ * Google Benchmark harness for tracking performance across versions:
+ * - Graph build throughput through addRoute
+ * - removeLocation cost
+ * - optimizeDeliveryPlan and simulateDelivery latency
+ * - Vectorized against scalar edge relaxation
+ *
+ * Synthetic inputs (grid, random geometric, scale-free) are generated at
+ * several sizes. A real road network in DIMACS .gr format is benchmarked
+ * too when the DIMACS_GR environment variable points at one.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread delpathopt_bench.cpp -lbenchmark -o delpathopt_bench
+ */
+
+#define DELPATHOPT_NO_MAIN
+#include "delpathopt.cpp"
+
+#include <benchmark/benchmark.h>  // Google Benchmark
+#include <map>                    // For the per-input graph cache
+#include <random>                 // For synthetic graph generators
+#include <cstdlib>                // For getenv
+
+/*
+ * GraphSpec struct
+ * Generated input: location count and undirected routes
+ */
+struct GraphSpec {
+    int n = 0;                               // Number of locations
+    vector<pair<int, int>> edges;            // Route endpoints
+    vector<int> costs;                       // Route costs (parallel to edges)
+    vector<GeoPoint> coordinates;            // Positions (empty if none)
+};
+
+// Input families, selected by the first benchmark argument
+enum GraphKind { Grid = 0, Geometric = 1, ScaleFree = 2, Dimacs = 3 };
+
+static const char* kindName(int kind) {
+    static const char* names[] = { "grid", "geometric", "scale-free", "dimacs" };
+    return names[kind];
+}
+
+/*
+ * Square grid with 4-neighbour streets and random block costs
+ * @param n: Approximate number of locations (rounded to a square)
+ */
+static GraphSpec makeGrid(int n) {
+    GraphSpec spec;
+    int side = max(2, (int)sqrt((double)n));
+    spec.n = side * side;
+    mt19937 rng(1);
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            int v = y * side + x;
+            GeoPoint p;
+            p.lat = 52.0 + y * 0.001;
+            p.lon = 13.0 + x * 0.001;
+            spec.coordinates.push_back(p);
+            if (x + 1 < side) { spec.edges.push_back(make_pair(v, v + 1)); spec.costs.push_back(1 + rng() % 10); }
+            if (y + 1 < side) { spec.edges.push_back(make_pair(v, v + side)); spec.costs.push_back(1 + rng() % 10); }
+        }
+    }
+    return spec;
+}
+
+/*
+ * Random geometric graph: points in the unit square joined to every point
+ * within a radius chosen for an average degree of about 8; cost is
+ * proportional to length
+ * @param n: Number of locations
+ */
+static GraphSpec makeGeometric(int n) {
+    GraphSpec spec;
+    spec.n = n;
+    mt19937 rng(2);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    vector<double> xs(n), ys(n);
+    for (int i = 0; i < n; ++i) {
+        xs[i] = unit(rng);
+        ys[i] = unit(rng);
+        GeoPoint p;
+        p.lat = 52.0 + ys[i];
+        p.lon = 13.0 + xs[i];
+        spec.coordinates.push_back(p);
+    }
+
+    // Bucket points into cells of the radius so only nearby cells are compared
+    double radius = sqrt(8.0 / (3.14159265358979323846 * n));
+    int cells = max(1, (int)(1.0 / radius));
+    vector<vector<int>> grid(cells * cells);
+    auto cellOf = [&](double c) { return min(cells - 1, (int)(c * cells)); };
+    for (int i = 0; i < n; ++i) grid[cellOf(ys[i]) * cells + cellOf(xs[i])].push_back(i);
+    for (int i = 0; i < n; ++i) {
+        int cx = cellOf(xs[i]), cy = cellOf(ys[i]);
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                int nx = cx + dx, ny = cy + dy;
+                if (nx < 0 || ny < 0 || nx >= cells || ny >= cells) continue;
+                for (int j : grid[ny * cells + nx]) {
+                    if (j <= i) continue;
+                    double d = hypot(xs[i] - xs[j], ys[i] - ys[j]);
+                    if (d > radius) continue;
+                    spec.edges.push_back(make_pair(i, j));
+                    spec.costs.push_back(1 + (int)(d * 10000));
+                }
+            }
+        }
+    }
+    return spec;
+}
+
+/*
+ * Scale-free graph by preferential attachment (Barabasi-Albert), 4 routes
+ * per new location
+ * @param n: Number of locations
+ */
+static GraphSpec makeScaleFree(int n) {
+    const int LINKS = 4;
+    GraphSpec spec;
+    spec.n = n;
+    mt19937 rng(3);
+    vector<int> endpoints; // Every route endpoint once, so picks follow degree
+    for (int v = 1; v < n; ++v) {
+        for (int k = 0; k < min(v, LINKS); ++k) {
+            int u = endpoints.empty() ? 0 : endpoints[rng() % endpoints.size()];
+            spec.edges.push_back(make_pair(v, u));
+            spec.costs.push_back(1 + rng() % 100);
+            endpoints.push_back(u);
+            endpoints.push_back(v);
+        }
+    }
+    return spec;
+}
+
+/*
+ * Loads a DIMACS shortest-path graph ("p sp n m" header, "a u v w" arcs,
+ * 1-based). Road networks list each street in both directions, so only
+ * arcs with u < v are kept.
+ * @param path: .gr file
+ */
+static GraphSpec loadDimacs(const string& path) {
+    GraphSpec spec;
+    MappedFile file;
+    if (!file.open(path, true)) return spec;
+    forEachLine(file.data(), file.size(), [&](const char* b, const char* e) {
+        if (b == e) return;
+        if (*b == 'p') {
+            long long n = 0, m = 0;
+            if (sscanf(string(b, e).c_str(), "p sp %lld %lld", &n, &m) == 2) {
+                spec.n = n;
+                spec.edges.reserve(m / 2);
+                spec.costs.reserve(m / 2);
+            }
+        } else if (*b == 'a') {
+            int u, v, w;
+            if (sscanf(string(b, e).c_str(), "a %d %d %d", &u, &v, &w) == 3 && u < v) {
+                spec.edges.push_back(make_pair(u - 1, v - 1));
+                spec.costs.push_back(w);
+            }
+        }
+    });
+    return spec;
+}
+
+/*
+ * Generates (once per process) the input for a benchmark argument pair
+ * @param kind: GraphKind
+ * @param n: Requested size (ignored for DIMACS)
+ * @return: The input, or null if a DIMACS file is not configured
+ */
+static const GraphSpec* graphSpec(int kind, int n) {
+    static map<pair<int, int>, GraphSpec> cache;
+    auto key = make_pair(kind, kind == Dimacs ? 0 : n);
+    auto it = cache.find(key);
+    if (it != cache.end()) return it->second.n ? &it->second : nullptr;
+
+    GraphSpec spec;
+    if (kind == Grid) spec = makeGrid(n);
+    else if (kind == Geometric) spec = makeGeometric(n);
+    else if (kind == ScaleFree) spec = makeScaleFree(n);
+    else if (const char* path = getenv("DIMACS_GR")) spec = loadDimacs(path);
+    GraphSpec& stored = cache[key] = move(spec);
+    return stored.n ? &stored : nullptr;
+}
+
+// Location name of a generated vertex
+static string nodeName(int v) {
+    return "N" + to_string(v);
+}
+
+/*
+ * Adds one location of an input to an optimizer
+ * @param dpo: Target optimizer
+ * @param spec: Input graph
+ * @param v: Vertex to add
+ */
+static void addLocation(DeliveryPathOptimizer& dpo, const GraphSpec& spec, int v) {
+    if (spec.coordinates.empty())
+        dpo.addLocation(nodeName(v));
+    else
+        dpo.addLocation(nodeName(v), spec.coordinates[v].lat, spec.coordinates[v].lon);
+}
+
+/*
+ * Adds every location of an input to an optimizer
+ * @param dpo: Target optimizer
+ * @param spec: Input graph
+ */
+static void addLocations(DeliveryPathOptimizer& dpo, const GraphSpec& spec) {
+    for (int v = 0; v < spec.n; ++v) addLocation(dpo, spec, v);
+}
+
+/*
+ * Fully built optimizer for an input (shared between benchmarks)
+ * @param spec: Input graph
+ */
+static DeliveryPathOptimizer& builtOptimizer(const GraphSpec& spec) {
+    static map<const GraphSpec*, unique_ptr<DeliveryPathOptimizer>> cache;
+    unique_ptr<DeliveryPathOptimizer>& dpo = cache[&spec];
+    if (!dpo) {
+        dpo.reset(new DeliveryPathOptimizer());
+        dpo->setResultCacheLimit(0); // Measure searches, not cache hits
+        addLocations(*dpo, spec);
+        for (size_t i = 0; i < spec.edges.size(); ++i) {
+            dpo->addRoute(nodeName(spec.edges[i].first), nodeName(spec.edges[i].second), spec.costs[i]);
+        }
+        dpo->freeze();
+    }
+    return *dpo;
+}
+
+// Resolves the input of a benchmark run, or skips the run
+static const GraphSpec* inputFor(benchmark::State& state) {
+    const GraphSpec* spec = graphSpec(state.range(0), state.range(1));
+    if (!spec) {
+        state.SkipWithError("set DIMACS_GR to a .gr file to benchmark a road network");
+        return nullptr;
+    }
+    state.SetLabel(kindName(state.range(0)));
+    state.counters["locations"] = spec->n;
+    state.counters["routes"] = spec->edges.size();
+    return spec;
+}
+
+/*
+ * Graph construction through addRoute (locations added outside the timer)
+ */
+static void BM_AddRouteBuild(benchmark::State& state) {
+    const GraphSpec* spec = inputFor(state);
+    if (!spec) return;
+    vector<string> from(spec->edges.size()), to(spec->edges.size());
+    for (size_t i = 0; i < spec->edges.size(); ++i) {
+        from[i] = nodeName(spec->edges[i].first);
+        to[i] = nodeName(spec->edges[i].second);
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        DeliveryPathOptimizer* dpo = new DeliveryPathOptimizer();
+        addLocations(*dpo, *spec);
+        state.ResumeTiming();
+        for (size_t i = 0; i < from.size(); ++i) dpo->addRoute(from[i], to[i], spec->costs[i]);
+        state.PauseTiming();
+        delete dpo;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * spec->edges.size()); // Routes per second
+}
+
+/*
+ * removeLocation of a random location (restored outside the timer)
+ */
+static void BM_RemoveLocation(benchmark::State& state) {
+    const GraphSpec* spec = inputFor(state);
+    if (!spec) return;
+    DeliveryPathOptimizer& dpo = builtOptimizer(*spec);
+    vector<vector<pair<int, int>>> incident(spec->n); // (neighbor, cost) per location
+    for (size_t i = 0; i < spec->edges.size(); ++i) {
+        incident[spec->edges[i].first].push_back(make_pair(spec->edges[i].second, spec->costs[i]));
+        incident[spec->edges[i].second].push_back(make_pair(spec->edges[i].first, spec->costs[i]));
+    }
+    mt19937 rng(4);
+    for (auto _ : state) {
+        int v = rng() % spec->n;
+        dpo.removeLocation(nodeName(v));
+        state.PauseTiming();
+        addLocation(dpo, *spec, v);
+        for (const auto& p : incident[v]) {
+            if (p.first != v) dpo.addRoute(nodeName(v), nodeName(p.first), p.second);
+        }
+        state.ResumeTiming();
+    }
+    dpo.freeze();
+}
+
+/*
+ * Full single-source optimizeDeliveryPlan from random origins
+ */
+static void BM_OptimizeDeliveryPlan(benchmark::State& state) {
+    const GraphSpec* spec = inputFor(state);
+    if (!spec) return;
+    const DeliveryPathOptimizer& dpo = builtOptimizer(*spec);
+    mt19937 rng(5);
+    long long settled = 0;
+    for (auto _ : state) {
+        ShortestPathTree plan = dpo.optimizeDeliveryPlan(nodeName(rng() % spec->n));
+        for (int d : plan.distances) settled += d != numeric_limits<int>::max();
+        benchmark::DoNotOptimize(plan.distances.data());
+    }
+    state.counters["settled/s"] = benchmark::Counter(settled, benchmark::Counter::kIsRate);
+}
+
+/*
+ * simulateDelivery (BFS) from random origins; second argument pair selects
+ * the BFS strategy
+ */
+static void BM_SimulateDelivery(benchmark::State& state) {
+    const GraphSpec* spec = inputFor(state);
+    if (!spec) return;
+    const DeliveryPathOptimizer& dpo = builtOptimizer(*spec);
+    BfsMode mode = state.range(2) ? BfsMode::DirectionOptimizing : BfsMode::Sequential;
+    state.SetLabel(string(kindName(state.range(0))) + (state.range(2) ? "/direction-optimizing" : "/sequential"));
+    mt19937 rng(6);
+    long long visited = 0;
+    for (auto _ : state) {
+        RouteSimulation sim = dpo.simulateDelivery(nodeName(rng() % spec->n), mode);
+        visited += sim.visitOrder.size();
+        benchmark::DoNotOptimize(sim.visitOrder.data());
+    }
+    state.counters["settled/s"] = benchmark::Counter(visited, benchmark::Counter::kIsRate);
+}
+
+/*
+ * optimizeDeliveryPlan with each relaxation kernel; third argument is the
+ * SimdLevel (levels the CPU lacks are skipped)
+ */
+static void BM_RelaxationKernel(benchmark::State& state) {
+    const GraphSpec* spec = inputFor(state);
+    if (!spec) return;
+    SimdLevel requested = (SimdLevel)state.range(2);
+    if (setSimdLevel(requested) != requested) {
+        setSimdLevel(detectedSimdLevel());
+        state.SkipWithError("kernel not supported by this CPU");
+        return;
+    }
+    static const char* levelNames[] = { "scalar", "avx2", "avx512" };
+    state.SetLabel(string(kindName(state.range(0))) + "/" + levelNames[state.range(2)]);
+    const DeliveryPathOptimizer& dpo = builtOptimizer(*spec);
+    mt19937 rng(5);
+    long long settled = 0;
+    for (auto _ : state) {
+        ShortestPathTree plan = dpo.optimizeDeliveryPlan(nodeName(rng() % spec->n));
+        for (int d : plan.distances) settled += d != numeric_limits<int>::max();
+        benchmark::DoNotOptimize(plan.distances.data());
+    }
+    state.counters["settled/s"] = benchmark::Counter(settled, benchmark::Counter::kIsRate);
+    setSimdLevel(detectedSimdLevel());
+}
+
+// Synthetic families at three sizes, plus the optional DIMACS input
+static void graphArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({ "kind", "n" });
+    for (int kind : { Grid, Geometric, ScaleFree }) {
+        for (int n : { 1 << 12, 1 << 16, 1 << 20 }) b->Args({ kind, n });
+    }
+    b->Args({ Dimacs, 0 });
+}
+
+static void bfsArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({ "kind", "n", "mode" });
+    for (int kind : { Grid, Geometric, ScaleFree }) {
+        for (int n : { 1 << 12, 1 << 16, 1 << 20 }) {
+            for (int mode : { 0, 1 }) b->Args({ kind, n, mode });
+        }
+    }
+    b->Args({ Dimacs, 0, 0 });
+    b->Args({ Dimacs, 0, 1 });
+}
+
+// Hub-heavy families, where long edge lists reach the vector kernels
+static void kernelArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({ "kind", "n", "simd" });
+    for (int kind : { Geometric, ScaleFree }) {
+        for (int n : { 1 << 16, 1 << 20 }) {
+            for (int level : { 0, 1, 2 }) b->Args({ kind, n, level });
+        }
+    }
+    for (int level : { 0, 1, 2 }) b->Args({ Dimacs, 0, level });
+}
+
+BENCHMARK(BM_AddRouteBuild)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RemoveLocation)->Apply(graphArgs)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_OptimizeDeliveryPlan)->Apply(graphArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SimulateDelivery)->Apply(bfsArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RelaxationKernel)->Apply(kernelArgs)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,658 @@
+/*
+ * Delivery Path Optimizer - Regression Tests
+ *
+ * Randomized checks against a plain Dijkstra over a reference copy of the
+ * network:
+ * - Bidirectional point-to-point queries
+ * - ALT queries and landmark table files
+ * - Contraction hierarchy queries
+ * - Concurrent queries with per-thread workspaces
+ * - Snapshot file round trips
+ * - Incremental repair of tracked shortest-path trees
+ * - Result cache hits, version invalidation and memory cap
+ * - Every vertex order
+ * - Batched route changes folded in at commitBatch()
+ *
+ * Prints one line per failed check and exits non-zero if any failed.
+ *
+ * Build: g++ -std=c++17 -O2 -pthread delpathopt_test.cpp -o delpathopt_test
+ */
+
+#define DELPATHOPT_NO_MAIN
+#include "delpathopt.cpp"
+
+#include <map>      // For the reference route table
+#include <random>   // For random networks and edits
+#include <cstdio>   // For removing scratch files
+
+const int UNREACHED = numeric_limits<int>::max();
+
+static int failures = 0;
+
+/*
+ * Records a failed check
+ * @param what: Check description
+ * @param trial: Random trial the check ran in
+ */
+static void fail(const string& what, int trial) {
+    failures++;
+    cout << "FAIL " << what << " (trial " << trial << ")" << endl;
+}
+
+/*
+ * ReferenceNetwork struct
+ * What the optimizer should hold: live locations and the cheapest cost of
+ * every undirected route, kept with plain containers
+ */
+struct ReferenceNetwork {
+    int n = 0;                           // Locations created (live or not)
+    vector<bool> live;                   // Live flag per location number
+    map<pair<int, int>, int> routes;     // (smaller, larger) -> cheapest cost
+
+    static string name(int v) { return "L" + to_string(v); }
+    static pair<int, int> key(int u, int v) { return make_pair(min(u, v), max(u, v)); }
+
+    /*
+     * Plain Dijkstra with a binary heap over location numbers
+     * @param src: Origin location number
+     * @return: Distance per location number (UNREACHED if unreachable)
+     */
+    vector<int> distancesFrom(int src) const {
+        vector<vector<pair<int, int>>> adj(n);
+        for (const auto& r : routes) {
+            adj[r.first.first].push_back(make_pair(r.first.second, r.second));
+            adj[r.first.second].push_back(make_pair(r.first.first, r.second));
+        }
+        vector<int> dist(n, UNREACHED);
+        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+        dist[src] = 0;
+        pq.push(make_pair(0, src));
+        while (!pq.empty()) {
+            pair<int, int> top = pq.top();
+            pq.pop();
+            if (top.first > dist[top.second]) continue;
+            for (const auto& e : adj[top.second]) {
+                if (dist[e.first] > top.first + e.second) {
+                    dist[e.first] = top.first + e.second;
+                    pq.push(make_pair(dist[e.first], e.first));
+                }
+            }
+        }
+        return dist;
+    }
+};
+
+/*
+ * Builds the same random network in an optimizer and its reference copy
+ * @param rng: Random source
+ * @param dpo: Empty optimizer
+ * @param ref: Empty reference
+ * @param n: Number of locations
+ * @param routes: Number of routes to add (parallel routes included)
+ */
+static void buildRandom(mt19937& rng, DeliveryPathOptimizer& dpo, ReferenceNetwork& ref, int n, int routes) {
+    ref.n = n;
+    ref.live.assign(n, true);
+    for (int v = 0; v < n; ++v) {
+        dpo.addLocation(ReferenceNetwork::name(v), 52.0 + (rng() % 1000) * 1e-4, 13.0 + (rng() % 1000) * 1e-4);
+    }
+    for (int i = 0; i < routes; ++i) {
+        int u = rng() % n, v = rng() % n, cost = 1 + rng() % 100;
+        if (u == v) continue;
+        dpo.addRoute(ReferenceNetwork::name(u), ReferenceNetwork::name(v), cost);
+        auto it = ref.routes.find(ReferenceNetwork::key(u, v));
+        if (it == ref.routes.end()) ref.routes[ReferenceNetwork::key(u, v)] = cost;
+        else it->second = min(it->second, cost);
+    }
+}
+
+/*
+ * Compares a single-source result with the reference
+ * @param dpo: Optimizer the tree came from
+ * @param ref: Reference network
+ * @param src: Origin location number
+ * @param distances: Distance per location index
+ * @return: True if every live location matches
+ */
+static bool sameDistances(const DeliveryPathOptimizer& dpo, const ReferenceNetwork& ref, int src,
+                          const vector<int>& distances) {
+    vector<int> expected = ref.distancesFrom(src);
+    for (int v = 0; v < ref.n; ++v) {
+        if (!ref.live[v]) continue;
+        int index = dpo.locationIndex(ReferenceNetwork::name(v));
+        if (index < 0 || index >= (int)distances.size() || distances[index] != expected[v]) return false;
+    }
+    return true;
+}
+
+/*
+ * Checks that a tracked tree's predecessors form shortest paths
+ * @param dpo: Optimizer the tree came from
+ * @param ref: Reference network
+ * @param tree: Tracked tree with predecessors
+ */
+static bool consistentPredecessors(const DeliveryPathOptimizer& dpo, const ReferenceNetwork& ref,
+                                   const ShortestPathTree& tree) {
+    for (int v = 0; v < ref.n; ++v) {
+        if (!ref.live[v]) continue;
+        int index = dpo.locationIndex(ReferenceNetwork::name(v));
+        int p = tree.predecessors[index];
+        if (p < 0) continue;
+        string_view pred = dpo.locationName(p);
+        int u = stoi(string(pred.substr(1)));
+        auto it = ref.routes.find(ReferenceNetwork::key(u, v));
+        if (it == ref.routes.end() || tree.distances[p] + it->second != tree.distances[index]) return false;
+    }
+    return true;
+}
+
+/*
+ * Applies one random route change to both copies
+ * @param rng: Random source
+ * @param dpo: Optimizer (batched or not)
+ * @param ref: Reference network
+ * @return: Status of the optimizer call (Status::NothingToDo if none was made)
+ */
+static Status randomRouteChange(mt19937& rng, DeliveryPathOptimizer& dpo, ReferenceNetwork& ref) {
+    int u = rng() % ref.n, v = rng() % ref.n;
+    if (u == v || !ref.live[u] || !ref.live[v]) return Status::NothingToDo;
+    string a = ReferenceNetwork::name(u), b = ReferenceNetwork::name(v);
+    pair<int, int> k = ReferenceNetwork::key(u, v);
+    int cost = 1 + rng() % 100;
+    Status status;
+    switch (rng() % 3) {
+        case 0:
+            status = dpo.addRoute(a, b, cost);
+            ref.routes[k] = ref.routes.count(k) ? min(ref.routes[k], cost) : cost;
+            break;
+        case 1:
+            status = dpo.updateRouteCost(a, b, cost);
+            if (ref.routes.count(k)) ref.routes[k] = cost;
+            break;
+        default:
+            status = dpo.removeRoute(a, b);
+            ref.routes.erase(k);
+            break;
+    }
+    return status;
+}
+
+/*
+ * Removes a random live location other than L0 from both copies
+ */
+static void randomRemoval(mt19937& rng, DeliveryPathOptimizer& dpo, ReferenceNetwork& ref) {
+    int v = 1 + rng() % (ref.n - 1);
+    if (!ref.live[v]) return;
+    dpo.removeLocation(ReferenceNetwork::name(v));
+    ref.live[v] = false;
+    for (auto it = ref.routes.begin(); it != ref.routes.end();) {
+        if (it->first.first == v || it->first.second == v) it = ref.routes.erase(it);
+        else ++it;
+    }
+}
+
+/*
+ * Reads a whole file
+ * @param path: File to read
+ * @return: Its bytes (empty if unreadable)
+ */
+static string readFile(const string& path) {
+    ifstream in(path, ios::binary);
+    return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+/*
+ * Replaces a file's contents
+ * @param path: File to write
+ * @param bytes: New contents
+ */
+static void writeFile(const string& path, const string& bytes) {
+    ofstream out(path, ios::binary);
+    out.write(bytes.data(), bytes.size());
+}
+
+/*
+ * Runs random point-to-point queries with one strategy and compares them
+ * with the reference: reachability, ETA, and stops along existing routes
+ * that add up to the ETA
+ * @param rng: Random source
+ * @param dpo: Optimizer to query
+ * @param ref: Reference network
+ * @param mode: Search strategy
+ * @param queries: Number of random pairs
+ * @return: False at the first mismatch
+ */
+static bool sameShortestPaths(mt19937& rng, const DeliveryPathOptimizer& dpo, const ReferenceNetwork& ref,
+                              SearchMode mode, int queries) {
+    for (int q = 0; q < queries; ++q) {
+        int s = rng() % ref.n, t = rng() % ref.n;
+        if (!ref.live[s] || !ref.live[t]) continue;
+        int expected = ref.distancesFrom(s)[t];
+        PathResult r = dpo.shortestPath(ReferenceNetwork::name(s), ReferenceNetwork::name(t), mode);
+        if (r.status != Status::Ok || r.found != (expected != UNREACHED)) return false;
+        if (!r.found) continue;
+        if (r.eta != expected || r.stops.front() != ReferenceNetwork::name(s) ||
+            r.stops.back() != ReferenceNetwork::name(t)) {
+            return false;
+        }
+        long long sum = 0;
+        for (size_t i = 1; i < r.stops.size(); ++i) {
+            int u = stoi(r.stops[i - 1].substr(1)), v = stoi(r.stops[i].substr(1));
+            auto it = ref.routes.find(ReferenceNetwork::key(u, v));
+            if (it == ref.routes.end()) return false;
+            sum += it->second;
+        }
+        if (sum != expected) return false;
+    }
+    return true;
+}
+
+/*
+ * Bidirectional search agrees with the reference under every queue
+ * backend, with and without removed locations
+ */
+static void testBidirectional(mt19937& rng) {
+    for (int trial = 0; trial < 20; ++trial) {
+        DeliveryPathOptimizer dpo;
+        ReferenceNetwork ref;
+        buildRandom(rng, dpo, ref, 20 + rng() % 100, 150 + rng() % 150);
+        if (trial % 3 == 0) randomRemoval(rng, dpo, ref);
+        dpo.setHeapKind((HeapKind)(trial % 5));
+        if (!sameShortestPaths(rng, dpo, ref, SearchMode::Bidirectional, 40)) fail("bidirectional search", trial);
+    }
+}
+
+/*
+ * ALT search agrees with the reference for any landmark count, saved
+ * tables load back onto the same network only, and damaged tables are
+ * rejected
+ */
+static void testLandmarks(mt19937& rng) {
+    const string tablePath = "delpathopt_test_landmarks.bin";
+    const string damagedPath = "delpathopt_test_damaged.bin";
+    for (int trial = 0; trial < 12; ++trial) {
+        DeliveryPathOptimizer dpo;
+        ReferenceNetwork ref;
+        buildRandom(rng, dpo, ref, 20 + rng() % 100, 150 + rng() % 150);
+        if (trial % 3 == 0) randomRemoval(rng, dpo, ref);
+        dpo.buildLandmarks(1 + trial % 6);
+        if (!sameShortestPaths(rng, dpo, ref, SearchMode::ALT, 40)) fail("ALT search", trial);
+        if (dpo.saveLandmarks(tablePath) != Status::Ok) {
+            fail("landmark save", trial);
+            continue;
+        }
+        if (dpo.loadLandmarks(tablePath) != Status::Ok) fail("landmark load", trial);
+        if (!sameShortestPaths(rng, dpo, ref, SearchMode::ALT, 20)) fail("ALT search on loaded table", trial);
+
+        // Header: magic, version, landmark count, vertex count, fingerprint
+        string table = readFile(tablePath);
+        const size_t countAt = 2 * sizeof(uint32_t), idsAt = 4 * sizeof(uint32_t) + sizeof(uint64_t);
+        writeFile(damagedPath, table.substr(0, table.size() - sizeof(int32_t)));
+        if (dpo.loadLandmarks(damagedPath) != Status::IoError) fail("truncated landmarks rejected", trial);
+        string damaged = table;
+        uint32_t hugeCount = 0x40000000;
+        memcpy(&damaged[countAt], &hugeCount, sizeof(hugeCount));
+        writeFile(damagedPath, damaged);
+        if (dpo.loadLandmarks(damagedPath) != Status::IoError) fail("oversized landmark count rejected", trial);
+        damaged = table;
+        int32_t outOfRange = dpo.indexCount();
+        memcpy(&damaged[idsAt], &outOfRange, sizeof(outOfRange));
+        writeFile(damagedPath, damaged);
+        if (dpo.loadLandmarks(damagedPath) != Status::IoError) fail("out-of-range landmark rejected", trial);
+
+        // A changed network no longer matches the saved table
+        dpo.addRoute(ReferenceNetwork::name(0), ReferenceNetwork::name(1), 1);
+        if (dpo.loadLandmarks(tablePath) != Status::StaleData) fail("stale landmarks rejected", trial);
+    }
+    remove(tablePath.c_str());
+    remove(damagedPath.c_str());
+}
+
+/*
+ * Contraction hierarchy queries agree with the reference, route changes
+ * drop the stale hierarchy, and a rebuilt one agrees again
+ */
+static void testHierarchy(mt19937& rng) {
+    for (int trial = 0; trial < 12; ++trial) {
+        DeliveryPathOptimizer dpo;
+        ReferenceNetwork ref;
+        buildRandom(rng, dpo, ref, 20 + rng() % 100, 150 + rng() % 150);
+        if (trial % 3 == 0) randomRemoval(rng, dpo, ref);
+        dpo.buildContractionHierarchy();
+        if (!sameShortestPaths(rng, dpo, ref, SearchMode::ContractionHierarchy, 40)) {
+            fail("hierarchy search", trial);
+        }
+        for (int i = 0; i < 10; ++i) randomRouteChange(rng, dpo, ref);
+        if (!sameShortestPaths(rng, dpo, ref, SearchMode::ContractionHierarchy, 20)) {
+            fail("hierarchy search after route changes", trial);
+        }
+        dpo.buildContractionHierarchy();
+        if (!sameShortestPaths(rng, dpo, ref, SearchMode::ContractionHierarchy, 40)) {
+            fail("rebuilt hierarchy search", trial);
+        }
+    }
+}
+
+/*
+ * Threads with their own workspaces query right after a mutation, so the
+ * first of them builds the snapshot while the others wait for it, and all
+ * of them get the reference distances
+ */
+static void testConcurrentQueries(mt19937& rng) {
+    for (int trial = 0; trial < 8; ++trial) {
+        DeliveryPathOptimizer dpo;
+        ReferenceNetwork ref;
+        buildRandom(rng, dpo, ref, 50 + rng() % 150, 400);
+        for (int round = 0; round < 5; ++round) {
+            randomRouteChange(rng, dpo, ref);
+            vector<char> ok(4, 0);
+            vector<thread> threads;
+            for (int t = 0; t < 4; ++t) {
+                threads.emplace_back([&, t]() {
+                    QueryWorkspace ws;
+                    ok[t] = sameDistances(dpo, ref, t, dpo.optimizeDeliveryPlan(ReferenceNetwork::name(t), ws).distances);
+                });
+            }
+            for (thread& t : threads) t.join();
+            if (count(ok.begin(), ok.end(), 0) != 0) fail("concurrent delivery plans", trial);
+        }
+    }
+}
+
+/*
+ * Snapshots load back to the same answers, and damaged files are rejected
+ * without touching the loaded network
+ */
+static void testSnapshots(mt19937& rng) {
+    const string snapshotPath = "delpathopt_test_snapshot.bin";
+    const string damagedPath = "delpathopt_test_damaged.bin";
+    for (int trial = 0; trial < 10; ++trial) {
+        DeliveryPathOptimizer dpo;
+        ReferenceNetwork ref;
+        buildRandom(rng, dpo, ref, 20 + rng() % 80, 200);
+        if (trial % 2) randomRemoval(rng, dpo, ref);
+        if (dpo.saveSnapshot(snapshotPath) != Status::Ok) {
+            fail("snapshot save", trial);
+            continue;
+        }
+        DeliveryPathOptimizer loaded;
+        if (loaded.loadSnapshot(snapshotPath) != Status::Ok) {
+            fail("snapshot load", trial);
+            continue;
+        }
+        for (int s = 0; s < ref.n; s += 7) {
+            if (!ref.live[s]) continue;
+            if (!sameDistances(loaded, ref, s, loaded.optimizeDeliveryPlan(ReferenceNetwork::name(s)).distances)) {
+                fail("snapshot distances", trial);
+                break;
+            }
+        }
+
+        string bytes = readFile(snapshotPath);
+        SnapshotHeader header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        uint64_t version = loaded.graphVersion();
+        auto rejects = [&](const string& damaged) {
+            writeFile(damagedPath, damaged);
+            return loaded.loadSnapshot(damagedPath) == Status::IoError && loaded.graphVersion() == version &&
+                   loaded.locationIndex(ReferenceNetwork::name(0)) >= 0;
+        };
+        if (!rejects(bytes.substr(0, bytes.size() / 2))) fail("truncated snapshot rejected", trial);
+
+        // A route target past the last location
+        string damaged = bytes;
+        CSRGraph::Index outOfRange = (CSRGraph::Index)header.vertexCount;
+        memcpy(&damaged[header.targetsAt()], &outOfRange, sizeof(outOfRange));
+        if (header.edgeCount > 0 && !rejects(damaged)) fail("snapshot with bad target rejected", trial);
+
+        // Two live locations with the same name (equal lengths keep the
+        // name offsets valid)
+        vector<int> sameLength;
+        for (int v = 1; v < 10 && sameLength.size() < 2; ++v) {
+            if (ref.live[v]) sameLength.push_back(v);
+        }
+        const uint64_t* nameOffsets = (const uint64_t*)(bytes.data() + header.nameOffsetsAt());
+        damaged = bytes;
+        memcpy(&damaged[header.namesAt() + nameOffsets[sameLength[1]]],
+               bytes.data() + header.namesAt() + nameOffsets[sameLength[0]], 2);
+        if (!rejects(damaged)) fail("snapshot with duplicate names rejected", trial);
+    }
+    remove(snapshotPath.c_str());
+    remove(damagedPath.c_str());
+}
+
+/*
+ * Tracked trees stay equal to a fresh search through route changes,
+ * location removals and compaction
+ */
+static void testTrackedTrees(mt19937& rng) {
+    for (int trial = 0; trial < 30; ++trial) {
+        DeliveryPathOptimizer dpo;
+        ReferenceNetwork ref;
+        buildRandom(rng, dpo, ref, 20 + rng() % 80, 200);
+        dpo.trackSource("L0");
+        for (int step = 0; step < 60; ++step) {
+            if (step % 20 == 19) randomRemoval(rng, dpo, ref);
+            else if (step == 45) dpo.compact();
+            else randomRouteChange(rng, dpo, ref);
+            const ShortestPathTree* tree = dpo.trackedTree("L0");
+            if (!tree || !sameDistances(dpo, ref, 0, tree->distances)) {
+                fail("tracked tree distances", trial);
+                break;
+            }
+            if (!consistentPredecessors(dpo, ref, *tree)) {
+                fail("tracked tree predecessors", trial);
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * A repeated origin is answered from the result cache, every mutator bumps
+ * the graph version so the next lookup misses and returns fresh distances,
+ * and lowering the memory cap evicts least recently used trees
+ */
+static void testResultCache(mt19937& rng) {
+    const string scratchPath = "delpathopt_test_cache.bin";
+    for (int trial = 0; trial < 10; ++trial) {
+        DeliveryPathOptimizer dpo;
+        ReferenceNetwork ref;
+        buildRandom(rng, dpo, ref, 20 + rng() % 80, 200);
+        const string origin = ReferenceNetwork::name(1);
+
+        // First query misses, the same origin again hits
+        CacheStats before = dpo.resultCacheStats();
+        bool fresh = sameDistances(dpo, ref, 1, dpo.optimizeDeliveryPlan(origin).distances);
+        bool cached = sameDistances(dpo, ref, 1, dpo.optimizeDeliveryPlan(origin).distances);
+        CacheStats after = dpo.resultCacheStats();
+        if (!fresh || !cached) fail("cached plan distances", trial);
+        if (after.misses != before.misses + 1 || after.hits != before.hits + 1) fail("repeated origin hits", trial);
+
+        // Every mutator, applied to both copies where it changes routes
+        pair<int, int> first = ref.routes.begin()->first;
+        string a = ReferenceNetwork::name(first.first), b = ReferenceNetwork::name(first.second);
+        vector<pair<string, function<void()>>> mutators = {
+            { "addLocation", [&]() { dpo.addLocation("Extra"); } },
+            { "addRoute", [&]() {
+                dpo.addRoute(ReferenceNetwork::name(1), ReferenceNetwork::name(2), 1);
+                ref.routes[ReferenceNetwork::key(1, 2)] = 1;
+            } },
+            { "updateRouteCost", [&]() {
+                dpo.updateRouteCost(a, b, 7);
+                ref.routes[first] = 7;
+            } },
+            { "setRouteProfile", [&]() { dpo.setRouteProfile(a, b, { { 0, 30 }, { 600, 40 } }); } },
+            { "clearRouteProfile", [&]() { dpo.clearRouteProfile(a, b); } },
+            { "removeRoute", [&]() {
+                dpo.removeRoute(a, b);
+                ref.routes.erase(first);
+            } },
+            { "commitBatch", [&]() {
+                dpo.beginBatch();
+                dpo.addRoute(ReferenceNetwork::name(1), ReferenceNetwork::name(3), 2);
+                ref.routes[ReferenceNetwork::key(1, 3)] = 2;
+                dpo.commitBatch();
+            } },
+            { "removeLocation", [&]() {
+                dpo.removeLocation(ReferenceNetwork::name(4));
+                ref.live[4] = false;
+                for (auto it = ref.routes.begin(); it != ref.routes.end();) {
+                    if (it->first.first == 4 || it->first.second == 4) it = ref.routes.erase(it);
+                    else ++it;
+                }
+            } },
+            { "compact", [&]() { dpo.compact(); } },
+            { "setVertexOrder", [&]() { dpo.setVertexOrder(VertexOrder::BFS); } },
+            { "importGraph", [&]() {
+                ofstream out(scratchPath);
+                out << ReferenceNetwork::name(1) << "," << ReferenceNetwork::name(5) << ",3\n";
+                out.close();
+                dpo.importGraph("", scratchPath);
+                auto it = ref.routes.find(ReferenceNetwork::key(1, 5));
+                ref.routes[ReferenceNetwork::key(1, 5)] = (it == ref.routes.end()) ? 3 : min(it->second, 3);
+            } },
+            { "loadSnapshot", [&]() {
+                dpo.saveSnapshot(scratchPath);
+                dpo.loadSnapshot(scratchPath);
+            } },
+        };
+        for (const auto& m : mutators) {
+            uint64_t version = dpo.graphVersion();
+            m.second();
+            if (dpo.graphVersion() == version) fail(m.first + " bumps the graph version", trial);
+            before = dpo.resultCacheStats();
+            fresh = sameDistances(dpo, ref, 1, dpo.optimizeDeliveryPlan(origin).distances);
+            cached = sameDistances(dpo, ref, 1, dpo.optimizeDeliveryPlan(origin).distances);
+            after = dpo.resultCacheStats();
+            if (!fresh || !cached) fail("plan distances after " + m.first, trial);
+            if (after.misses != before.misses + 1 || after.hits != before.hits + 1) {
+                fail(m.first + " invalidates the cached plan", trial);
+            }
+        }
+
+        // A cap of two trees keeps only the two most recent origins
+        size_t treeBytes = dpo.resultCacheStats().bytes / max<size_t>(1, dpo.resultCacheStats().entries);
+        dpo.setResultCacheLimit(treeBytes * 2 + treeBytes / 2);
+        const int origins[] = { 0, 2, 3, 5, 6, 7 }; // Live, and not cached yet
+        for (int s : origins) dpo.optimizeDeliveryPlan(ReferenceNetwork::name(s));
+        CacheStats capped = dpo.resultCacheStats();
+        if (capped.entries != 2 || capped.bytes > capped.capacityBytes || capped.evictions != 5) {
+            fail("memory cap evicts", trial);
+        }
+        before = dpo.resultCacheStats();
+        dpo.optimizeDeliveryPlan(ReferenceNetwork::name(7));
+        dpo.optimizeDeliveryPlan(ReferenceNetwork::name(0));
+        after = dpo.resultCacheStats();
+        if (after.hits != before.hits + 1 || after.misses != before.misses + 1) {
+            fail("least recently used origin evicted first", trial);
+        }
+
+        // A zero cap frees every tree and stops counting lookups
+        dpo.setResultCacheLimit(0);
+        before = dpo.resultCacheStats();
+        fresh = sameDistances(dpo, ref, 1, dpo.optimizeDeliveryPlan(origin).distances);
+        after = dpo.resultCacheStats();
+        if (!fresh || after.entries != 0 || after.bytes != 0 || after.hits != before.hits ||
+            after.misses != before.misses) {
+            fail("zero cap disables the cache", trial);
+        }
+    }
+    remove(scratchPath.c_str());
+}
+
+/*
+ * Renumbering the snapshot changes no answer: every vertex order gives the
+ * reference distances for delivery plans and every point-to-point strategy
+ */
+static void testVertexOrders(mt19937& rng) {
+    const SearchMode modes[] = { SearchMode::Dijkstra, SearchMode::Bidirectional, SearchMode::ALT,
+                                 SearchMode::ContractionHierarchy };
+    const VertexOrder orders[] = { VertexOrder::Insertion, VertexOrder::BFS,
+                                   VertexOrder::ReverseCuthillMcKee, VertexOrder::Hilbert };
+    for (int trial = 0; trial < 16; ++trial) {
+        DeliveryPathOptimizer dpo;
+        ReferenceNetwork ref;
+        buildRandom(rng, dpo, ref, 20 + rng() % 100, 150 + rng() % 150);
+        if (trial % 3 == 0) randomRemoval(rng, dpo, ref);
+        VertexOrder order = orders[trial % 4];
+        dpo.setVertexOrder(order);
+        dpo.buildLandmarks(4);
+        dpo.buildContractionHierarchy();
+        string label = " under order " + to_string((int)order);
+        for (SearchMode mode : modes) {
+            if (!sameShortestPaths(rng, dpo, ref, mode, 20)) fail("mode " + to_string((int)mode) + label, trial);
+        }
+        for (int s = 0; s < ref.n; s += 5) {
+            if (!ref.live[s]) continue;
+            if (!sameDistances(dpo, ref, s, dpo.optimizeDeliveryPlan(ReferenceNetwork::name(s)).distances)) {
+                fail("delivery plan" + label, trial);
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * Changes queued in a batch are invisible until commitBatch() and then
+ * match the reference, with tracked trees repaired as well. Every queued
+ * call returns the status the same call gets on a twin network that
+ * applies it directly.
+ */
+static void testBatches(mt19937& rng) {
+    for (int trial = 0; trial < 30; ++trial) {
+        DeliveryPathOptimizer dpo, direct;
+        ReferenceNetwork ref, directRef;
+        int n = 20 + rng() % 80;
+        mt19937 twin = rng;
+        buildRandom(rng, dpo, ref, n, 200);
+        buildRandom(twin, direct, directRef, n, 200);
+        dpo.trackSource("L0");
+        for (int round = 0; round < 4; ++round) {
+            ReferenceNetwork before = ref;
+            if (dpo.beginBatch() != Status::Ok) fail("beginBatch", trial);
+            if (dpo.beginBatch() != Status::NothingToDo) fail("nested beginBatch", trial);
+            int changes = 1 + rng() % 80;
+            for (int i = 0; i < changes; ++i) {
+                twin = rng;
+                Status queued = randomRouteChange(rng, dpo, ref);
+                if (randomRouteChange(twin, direct, directRef) != queued) fail("queued call status", trial);
+            }
+            if (dpo.removeLocation("L1") != Status::InvalidArgument || dpo.compact() != -1) {
+                fail("renumbering rejected while batching", trial);
+            }
+            pair<int, int> route = ref.routes.empty() ? make_pair(0, 1) : ref.routes.begin()->first;
+            string a = ReferenceNetwork::name(route.first), b = ReferenceNetwork::name(route.second);
+            if (dpo.setRouteProfile(a, b, { { 0, 10 } }) != Status::InvalidArgument ||
+                dpo.clearRouteProfile(a, b) != Status::InvalidArgument) {
+                fail("profile changes rejected while batching", trial);
+            }
+            if (!sameDistances(dpo, before, 0, dpo.optimizeDeliveryPlan("L0").distances)) {
+                fail("batched changes hidden before commit", trial);
+            }
+            if (dpo.commitBatch() != Status::Ok || dpo.pendingChangeCount() != 0) fail("commitBatch", trial);
+            if (!sameDistances(dpo, ref, 0, dpo.optimizeDeliveryPlan("L0").distances)) {
+                fail("batched changes after commit", trial);
+            }
+            if (!sameDistances(dpo, ref, 0, dpo.trackedTree("L0")->distances)) {
+                fail("tracked tree after commit", trial);
+            }
+        }
+        if (dpo.commitBatch() != Status::NothingToDo) fail("commit without batch", trial);
+    }
+}
+
+int main() {
+    mt19937 rng(20240601);
+    testBidirectional(rng);
+    testLandmarks(rng);
+    testHierarchy(rng);
+    testConcurrentQueries(rng);
+    testSnapshots(rng);
+    testTrackedTrees(rng);
+    testResultCache(rng);
+    testVertexOrders(rng);
+    testBatches(rng);
+    if (failures == 0) cout << "All tests passed" << endl;
+    return failures == 0 ? 0 : 1;
+}